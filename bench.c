@@ -0,0 +1,136 @@
+#include <dtype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// codec benchmark : prints compression ratio & decode speed for typical columns
+// store benchmark : prints checkpoint & restart times of a store under /tmp
+// build : gcc -O2 -I. bench.c dtype.c -o bench -lpthread
+
+/// @brief number of elements in every benchmarked column
+#define BENCH_LENGTH (1 << 22)
+/// @brief number of decodes timed per column
+#define BENCH_ROUNDS 10
+/// @brief number of slots in the benchmarked store
+#define BENCH_SLOTS (1 << 21)
+/// @brief file prefix of the benchmarked store
+#define BENCH_STORE "/tmp/dtype_bench_store"
+
+/// @brief current monotonic time in seconds
+double bench_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/// @brief encode column, time decoding it & print the results
+void bench_codec(const char * name, dtype_array arr, enum DTYPE_CODECS codec)
+{
+    size_t raw = arr.length * dtype_type_size(arr.type);
+    dtype block = dtype_array_encode(arr, codec, dtype_default());
+    double start = bench_now();
+    for ( int i = 0; i < BENCH_ROUNDS; i++ ) {
+        dtype_array_clear(dtype_array_decode(block.mem, block.size));
+    }
+    double secs = (bench_now() - start) / BENCH_ROUNDS;
+    printf(
+        "%-24s ratio %6.2fx  decode %6.2f GB/s\n", name, (double)raw / block.size, raw / secs / 1e9
+    );
+    dtype_clear(block);
+}
+
+/// @brief encode string values, time decoding them & print the results
+void bench_strings(const char * name, const dtype * vals, size_t count, size_t raw)
+{
+    dtype block = dtype_strings_encode(vals, count, dtype_default());
+    double start = bench_now();
+    for ( int i = 0; i < BENCH_ROUNDS; i++ ) {
+        size_t n;
+        dtype * out = dtype_strings_decode(block.mem, block.size, &n);
+        for ( size_t j = 0; j < n; j++ ) { dtype_clear(out[j]); }
+        free(out);
+    }
+    double secs = (bench_now() - start) / BENCH_ROUNDS;
+    printf(
+        "%-24s ratio %6.2fx  decode %6.2f GB/s\n", name, (double)raw / block.size, raw / secs / 1e9
+    );
+    dtype_clear(block);
+}
+
+/// @brief time checkpoints of a store with a small fraction of slots changed & reopening it
+void bench_store()
+{
+    remove(BENCH_STORE ".base");
+    remove(BENCH_STORE ".log");
+    dtype_store * store = dtype_store_open(BENCH_STORE, BENCH_SLOTS);
+    dtype val = dtype_default();
+    for ( size_t i = 0; i < BENCH_SLOTS; i++ ) {
+        val = i % 2 ? dtype_set_long(val, (long) i) : dtype_set_double(val, i * 0.5);
+        dtype_store_set(store, i, val);
+    }
+    double start = bench_now();
+    dtype_store_checkpoint(store);
+    printf("%-24s %8.2f ms\n", "store full checkpoint", (bench_now() - start) * 1e3);
+    double delta = 0;
+    for ( int round = 0; round < BENCH_ROUNDS; round++ ) {
+        // about 1% of slots change between checkpoints
+        for ( size_t i = 0; i < BENCH_SLOTS / 100; i++ ) {
+            val = dtype_set_long(val, rand());
+            dtype_store_set(store, (size_t) rand() % BENCH_SLOTS, val);
+        }
+        start = bench_now();
+        dtype_store_checkpoint(store);
+        delta += bench_now() - start;
+    }
+    printf("%-24s %8.2f ms\n", "store delta checkpoint", delta / BENCH_ROUNDS * 1e3);
+    dtype_store_close(store);
+    start = bench_now();
+    store = dtype_store_open(BENCH_STORE, 0);
+    printf("%-24s %8.2f ms\n", "store restart", (bench_now() - start) * 1e3);
+    dtype_store_close(store);
+    dtype_clear(val);
+    remove(BENCH_STORE ".base");
+    remove(BENCH_STORE ".log");
+}
+
+int main()
+{
+    srand(42);
+    dtype_array stamps = dtype_array_new(DTYPE_INT64, BENCH_LENGTH);
+    dtype_array sensor = dtype_array_new(DTYPE_INT32, BENCH_LENGTH);
+    dtype_array reading = dtype_array_new(DTYPE_DOUBLE, BENCH_LENGTH);
+    int64_t now = 1700000000000;
+    double level = 20.0;
+    for ( size_t i = 0; i < BENCH_LENGTH; i++ ) {
+        // millisecond timestamps with jitter, values in a narrow band, slowly drifting readings
+        now += 1000 + rand() % 16;
+        level += (rand() % 3 - 1) * 0.25;
+        ((int64_t *) stamps.mem)[i] = now;
+        ((int32_t *) sensor.mem)[i] = 4000 + rand() % 200;
+        ((double *) reading.mem)[i] = level;
+    }
+    bench_codec("int64 timestamps delta", stamps, DTYPE_CODEC_DELTA);
+    bench_codec("int32 sensor for", sensor, DTYPE_CODEC_FOR);
+    bench_codec("int32 sensor delta", sensor, DTYPE_CODEC_DELTA);
+    bench_codec("double readings xor", reading, DTYPE_CODEC_XOR);
+    bench_codec("double readings raw", reading, DTYPE_CODEC_RAW);
+
+    const char * levels[] = { "debug", "info", "warning", "error" };
+    size_t count = BENCH_LENGTH / 16;
+    size_t raw = 0;
+    dtype * vals = calloc(count, sizeof(dtype));
+    for ( size_t i = 0; i < count; i++ ) {
+        vals[i] = dtype_set_string(vals[i], (char *) levels[(i / 32 + rand() % 2) % 4]);
+        raw += vals[i].size;
+    }
+    bench_strings("string levels dict rle", vals, count, raw);
+
+    for ( size_t i = 0; i < count; i++ ) { dtype_clear(vals[i]); }
+    free(vals);
+    dtype_array_clear(stamps);
+    dtype_array_clear(sensor);
+    dtype_array_clear(reading);
+    bench_store();
+    return 0;
+}
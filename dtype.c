@@ -1,24 +1,58 @@
+// clock_gettime, fdatasync & O_CLOEXEC are POSIX, not part of strict ISO C
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <dtype.h>
 #include <stdbool.h>
 #include <string.h>
 #include <stdlib.h>
+#include <inttypes.h>
+#include <stdarg.h>
+
+#if defined(DTYPE_POSIX_IO)
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#include <immintrin.h>
+/// @brief set when x86 SIMD kernels with runtime dispatch are compiled in
+#define DTYPE_X86_SIMD 1
+#endif
 
 /// @brief array of strings mapping to string versions of typecode
-const char * DTYPE_STR_TYPES[] = {
-    "none",
-    "boolean",
-    "character",
-    "short",
-    "unsigned short",
-    "int",
-    "unsigned int",
-    "long",
-    "unsigned long",
-    "float",
-    "double",
-    "string",
-    "other (custom type)"
+const char * DTYPE_STR_TYPES[DTYPE_TYPES_END] = {
+    [DTYPE_NONE] = "none",
+    [DTYPE_BOOL] = "boolean",
+    [DTYPE_CHAR] = "character",
+    [DTYPE_SHORT] = "short",
+    [DTYPE_USHORT] = "unsigned short",
+    [DTYPE_INT] = "int",
+    [DTYPE_UINT] = "unsigned int",
+    [DTYPE_LONG] = "long",
+    [DTYPE_ULONG] = "unsigned long",
+    [DTYPE_FLOAT] = "float",
+    [DTYPE_DOUBLE] = "double",
+    [DTYPE_STRING] = "string",
+    [DTYPE_CUSTOM] = "other (custom type)",
+    [DTYPE_INT8] = "int8",
+    [DTYPE_UINT8] = "uint8",
+    [DTYPE_INT16] = "int16",
+    [DTYPE_UINT16] = "uint16",
+    [DTYPE_INT32] = "int32",
+    [DTYPE_UINT32] = "uint32",
+    [DTYPE_INT64] = "int64",
+    [DTYPE_UINT64] = "uint64",
+    [DTYPE_FLOAT16] = "float16",
+    [DTYPE_BFLOAT16] = "bfloat16",
+    [DTYPE_STRING_BUILDER] = "string builder",
 };
 
 // -------------------------------- Flags ----------------------------------------------
@@ -91,9 +125,9 @@ void dtype__mem_error(size_t size, const char * func)
 /// @return true if warning was displayed, else false.
 bool dtype__typecheck (dtype var, enum DTYPE_TYPES type) {
     // if the type is not within type range
-    if ( var.type < DTYPE_NONE || var.type > DTYPE_CUSTOM ) {
+    if ( var.type < DTYPE_NONE || var.type >= DTYPE_TYPES_END ) {
         if ( dtype__raise("dtype_typecheck", "Invalid type, type is corrupted.", DTYPE_TYPE_ERROR) ) {
-            fprintf(stderr, " type `%d` is not within ( %d >= type >= %d )\n", var.type, DTYPE_NONE, DTYPE_CUSTOM);
+            fprintf(stderr, " type `%d` is not within ( %d >= type >= %d )\n", var.type, DTYPE_NONE, DTYPE_TYPES_END - 1);
         }
         return true;
     }
@@ -130,6 +164,7 @@ dtype dtype__mem_refresh(dtype var, size_t size, const char * func)
     }
     var.mem = size ? dtype__mem_alloc(size): NULL;
     var.size = (var.mem != NULL) ? size : 0;
+    var.length = 0;
     var.type = DTYPE_NONE;
     if(!var.size && size) {
         dtype__mem_error(size, func);
@@ -137,6 +172,308 @@ dtype dtype__mem_refresh(dtype var, size_t size, const char * func)
     return var;
 }
 
+/// @brief float to half precision conversion for internal use [ round to nearest even ]
+/// @param val the float to convert
+/// @return the raw bits of half precision value
+uint16_t dtype__float_to_half(float val)
+{
+    uint32_t x;
+    memcpy(&x, &val, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t absx = x & 0x7fffffff;
+    // inf or nan, keep nan quiet and preserve upper payload bits
+    if ( absx >= 0x7f800000 ) {
+        return sign | 0x7c00 | ( absx > 0x7f800000 ? 0x200 | ((absx >> 13) & 0x3ff) : 0 );
+    }
+    // 65520 and above rounds to inf
+    if ( absx >= 0x477ff000 ) { return sign | 0x7c00; }
+    // below 2^-14 results in a subnormal half (or zero)
+    if ( absx < 0x38800000 ) {
+        if ( absx < 0x33000000 ) { return sign; }
+        uint32_t shift = 126 - (absx >> 23);
+        uint32_t mant = (absx & 0x7fffff) | 0x800000;
+        uint32_t res = mant >> shift;
+        uint32_t rem = mant & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if ( rem > halfway || (rem == halfway && (res & 1)) ) { res++; }
+        return sign | res;
+    }
+    // normal range, rebias exponent from 127 to 15
+    uint32_t res = (absx - 0x38000000) >> 13;
+    uint32_t rem = absx & 0x1fff;
+    if ( rem > 0x1000 || (rem == 0x1000 && (res & 1)) ) { res++; }
+    return sign | res;
+}
+
+/// @brief half precision to float conversion for internal use
+/// @param half the raw bits of half precision value
+/// @return the value as float
+float dtype__half_to_float(uint16_t half)
+{
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exp = (half >> 10) & 0x1f;
+    uint32_t mant = half & 0x3ff;
+    uint32_t x;
+    if ( exp == 0x1f ) {
+        // inf or nan, nan is always quieted [ same as F16C does ]
+        x = sign | 0x7f800000 | (mant << 13) | (mant ? 0x400000 : 0);
+    } else if ( exp == 0 ) {
+        if ( mant == 0 ) {
+            x = sign;
+        } else {
+            // subnormal half, normalize it for float
+            exp = 113;
+            while ( !(mant & 0x400) ) { mant <<= 1; exp--; }
+            x = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+        }
+    } else {
+        x = sign | ((exp + 112) << 23) | (mant << 13);
+    }
+    float val;
+    memcpy(&val, &x, sizeof(val));
+    return val;
+}
+
+/// @brief float to brain float conversion for internal use [ round to nearest even ]
+/// @param val the float to convert
+/// @return the raw bits of brain float value
+uint16_t dtype__float_to_bfloat(float val)
+{
+    uint32_t x;
+    memcpy(&x, &val, sizeof(x));
+    // nan, make sure it stays nan after truncation
+    if ( (x & 0x7fffffff) > 0x7f800000 ) { return (uint16_t)((x >> 16) | 0x40); }
+    x += 0x7fff + ((x >> 16) & 1);
+    return (uint16_t)(x >> 16);
+}
+
+/// @brief brain float to float conversion for internal use
+/// @param bfloat the raw bits of brain float value
+/// @return the value as float
+float dtype__bfloat_to_float(uint16_t bfloat)
+{
+    uint32_t x = (uint32_t)bfloat << 16;
+    float val;
+    memcpy(&val, &x, sizeof(val));
+    return val;
+}
+
+#if defined(DTYPE_X86_SIMD)
+
+/// @brief check whether F16C instructions can be used, for internal use
+/// @return true if cpu supports F16C and AVX
+bool dtype__cpu_has_f16c()
+{
+    static int has = -1;
+    if ( has < 0 ) {
+        __builtin_cpu_init();
+        has = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    }
+    return has;
+}
+
+/// @brief check whether AVX2 instructions can be used, for internal use
+/// @return true if cpu supports AVX2
+bool dtype__cpu_has_avx2()
+{
+    static int has = -1;
+    if ( has < 0 ) {
+        __builtin_cpu_init();
+        has = __builtin_cpu_supports("avx2");
+    }
+    return has;
+}
+
+/// @brief F16C kernel for float to half conversion, returns number of elements converted
+__attribute__((target("avx,f16c")))
+size_t dtype__float_to_half_f16c(uint16_t * dst, const float * src, size_t count)
+{
+    size_t i = 0;
+    for ( ; i + 8 <= count; i += 8 ) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i *)(dst + i), h);
+    }
+    return i;
+}
+
+/// @brief F16C kernel for half to float conversion, returns number of elements converted
+__attribute__((target("avx,f16c")))
+size_t dtype__half_to_float_f16c(float * dst, const uint16_t * src, size_t count)
+{
+    size_t i = 0;
+    for ( ; i + 8 <= count; i += 8 ) {
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(src + i))));
+    }
+    return i;
+}
+
+/// @brief AVX2 kernel for float to brain float conversion, returns number of elements converted
+__attribute__((target("avx2")))
+size_t dtype__float_to_bfloat_avx2(uint16_t * dst, const float * src, size_t count)
+{
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i bias = _mm256_set1_epi32(0x7fff);
+    const __m256i absmask = _mm256_set1_epi32(0x7fffffff);
+    const __m256i inf = _mm256_set1_epi32(0x7f800000);
+    const __m256i quiet = _mm256_set1_epi32(0x400000);
+    size_t i = 0;
+    for ( ; i + 8 <= count; i += 8 ) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(x, 16), one);
+        __m256i rounded = _mm256_add_epi32(x, _mm256_add_epi32(bias, lsb));
+        __m256i isnan = _mm256_cmpgt_epi32(_mm256_and_si256(x, absmask), inf);
+        __m256i res = _mm256_blendv_epi8(rounded, _mm256_or_si256(x, quiet), isnan);
+        res = _mm256_srli_epi32(res, 16);
+        // pack within lanes then gather the two useful quadwords into the low half
+        res = _mm256_permute4x64_epi64(_mm256_packus_epi32(res, res), 0xD8);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm256_castsi256_si128(res));
+    }
+    return i;
+}
+
+/// @brief AVX2 kernel for brain float to float conversion, returns number of elements converted
+__attribute__((target("avx2")))
+size_t dtype__bfloat_to_float_avx2(float * dst, const uint16_t * src, size_t count)
+{
+    size_t i = 0;
+    for ( ; i + 8 <= count; i += 8 ) {
+        __m256i x = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(src + i)));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_slli_epi32(x, 16));
+    }
+    return i;
+}
+
+#endif // DTYPE_X86_SIMD
+
+// -------------------------------- Internal Bitmap Functions ----------------------------------------------
+
+/// @brief number of 64-bit words needed to store given number of bits, for internal use
+/// @param bits number of bits
+/// @return number of words
+size_t dtype__bitmap_words(size_t bits)
+{
+    return (bits + 63) / 64;
+}
+
+/// @brief mask of the used bits in the last word of a bitmap, for internal use
+/// @param bits number of bits in the bitmap
+/// @return the mask to apply on the last word
+uint64_t dtype__bitmap_tail_mask(size_t bits)
+{
+    return (bits % 64) ? ((uint64_t)1 << (bits % 64)) - 1 : ~(uint64_t)0;
+}
+
+/// @brief get a bit from bitmap, for internal use
+bool dtype__bit_get(const uint64_t * bits, size_t index)
+{
+    return (bits[index / 64] >> (index % 64)) & 1;
+}
+
+/// @brief set a bit in bitmap, for internal use
+void dtype__bit_set(uint64_t * bits, size_t index, bool val)
+{
+    uint64_t bit = (uint64_t)1 << (index % 64);
+    bits[index / 64] = val ? (bits[index / 64] | bit) : (bits[index / 64] & ~bit);
+}
+
+/// @brief population count of a 64-bit word, for internal use
+size_t dtype__popcount64(uint64_t x)
+{
+#if defined(__GNUC__)
+    return (size_t)__builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (size_t)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/// @brief index of lowest set bit of a non zero 64-bit word, for internal use
+size_t dtype__ctz64(uint64_t x)
+{
+#if defined(__GNUC__)
+    return (size_t)__builtin_ctzll(x);
+#else
+    size_t n = 0;
+    while ( !(x & 1) ) { x >>= 1; n++; }
+    return n;
+#endif
+}
+
+#if defined(DTYPE_X86_SIMD)
+
+/// @brief check whether POPCNT instruction can be used, for internal use
+/// @return true if cpu supports POPCNT
+bool dtype__cpu_has_popcnt()
+{
+    static int has = -1;
+    if ( has < 0 ) {
+        __builtin_cpu_init();
+        has = __builtin_cpu_supports("popcnt");
+    }
+    return has;
+}
+
+/// @brief POPCNT kernel counting bits of `a & b` [ b may be NULL ]
+__attribute__((target("popcnt")))
+size_t dtype__bitmap_popcount_popcnt(const uint64_t * a, const uint64_t * b, size_t words)
+{
+    size_t count = 0;
+    if ( b == NULL ) {
+        for ( size_t i = 0; i < words; i++ ) { count += (size_t)__builtin_popcountll(a[i]); }
+    } else {
+        for ( size_t i = 0; i < words; i++ ) { count += (size_t)__builtin_popcountll(a[i] & b[i]); }
+    }
+    return count;
+}
+
+/// @brief AVX2 kernel for bitmap and / or / not [ op: 0 = and, 1 = or, 2 = not ], returns number of words done
+__attribute__((target("avx2")))
+size_t dtype__bitmap_op_avx2(uint64_t * dst, const uint64_t * a, const uint64_t * b, size_t words, int op)
+{
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    size_t i = 0;
+    for ( ; i + 4 <= words; i += 4 ) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i res;
+        if ( op == 2 ) {
+            res = _mm256_xor_si256(va, ones);
+        } else {
+            __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+            res = op ? _mm256_or_si256(va, vb) : _mm256_and_si256(va, vb);
+        }
+        _mm256_storeu_si256((__m256i *)(dst + i), res);
+    }
+    return i;
+}
+
+#endif // DTYPE_X86_SIMD
+
+/// @brief count set bits of `a & b` over given words [ b may be NULL ], for internal use
+size_t dtype__bitmap_popcount(const uint64_t * a, const uint64_t * b, size_t words)
+{
+#if defined(DTYPE_X86_SIMD)
+    if ( dtype__cpu_has_popcnt() ) { return dtype__bitmap_popcount_popcnt(a, b, words); }
+#endif
+    size_t count = 0;
+    for ( size_t i = 0; i < words; i++ ) { count += dtype__popcount64(b ? a[i] & b[i] : a[i]); }
+    return count;
+}
+
+/// @brief bitmap and / or / not over given words [ op: 0 = and, 1 = or, 2 = not ], for internal use
+void dtype__bitmap_op(uint64_t * dst, const uint64_t * a, const uint64_t * b, size_t words, int op)
+{
+    size_t i = 0;
+#if defined(DTYPE_X86_SIMD)
+    if ( dtype__cpu_has_avx2() ) { i = dtype__bitmap_op_avx2(dst, a, b, words, op); }
+#endif
+    // scalar tail ( or everything if no simd is available )
+    for ( ; i < words; i++ ) {
+        dst[i] = op == 2 ? ~a[i] : (op ? a[i] | b[i] : a[i] & b[i]);
+    }
+}
+
 // -------------------------------- External Functions ----------------------------------------------
 
 /// @brief get the string representation of type
@@ -152,6 +489,7 @@ const char * dtype_get_str_type(dtype var)
 dtype dtype_default() {
     dtype var;
     var.size = 0;
+    var.length = 0;
     var.mem = NULL;
     var.type = DTYPE_NONE;
     return var;
@@ -163,7 +501,18 @@ dtype dtype_default() {
 /// @return the dtype of given size.
 dtype dtype_change_size(dtype var, size_t size)
 {
-    var.mem = realloc(var.mem, size);
+    void * mem = realloc(var.mem, size);
+    if ( mem == NULL && size ) {
+        dtype__mem_error(size, "dtype_change_size");
+        return var;
+    }
+    var.mem = mem;
+    var.size = size;
+    // builder content is cut to fit along with its terminator
+    if ( var.type == DTYPE_STRING_BUILDER && var.length >= size ) {
+        var.length = size ? size - 1 : 0;
+        size ? ((char *)var.mem)[var.length] = '\0' : 0;
+    }
     return var;
 }
 
@@ -292,9 +641,9 @@ dtype dtype_set_float(dtype var, float val)
 /// @return the dtype variable with value as given
 dtype dtype_set_double(dtype var, double val)
 {
-    var = dtype__mem_refresh(var, sizeof(int), "dtype_set_double");
+    var = dtype__mem_refresh(var, sizeof(double), "dtype_set_double");
     // copy only if size of var is not zero else do nothing
-    var.size ? memcpy(var.mem, &val, sizeof(int)) : 0;
+    var.size ? memcpy(var.mem, &val, sizeof(double)) : 0;
     var.type = DTYPE_DOUBLE;
     return var;
 }
@@ -305,13 +654,146 @@ dtype dtype_set_double(dtype var, double val)
 /// @return the dtype variable with value as given
 dtype dtype_set_string(dtype var, char * val)
 {
-    var = dtype__mem_refresh(var, strlen(val)+1, "dtype_set_string");
+    size_t size = strlen(val) + 1;
+    var = dtype__mem_refresh(var, size, "dtype_set_string");
     // copy only if size of var is not zero else do nothing
-    var.size ? memcpy(var.mem, val, strlen(val)+1) : 0;
+    var.size ? memcpy(var.mem, val, size) : 0;
     var.type = DTYPE_STRING;
     return var;
 }
 
+/// @brief set the value to 8-bit signed integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_int8(dtype var, int8_t val)
+{
+    var = dtype__mem_refresh(var, sizeof(int8_t), "dtype_set_int8");
+    // copy only if size of var is not zero else do nothing
+    var.size ? memcpy(var.mem, &val, sizeof(int8_t)) : 0;
+    var.type = DTYPE_INT8;
+    return var;
+}
+
+/// @brief set the value to 8-bit unsigned integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_uint8(dtype var, uint8_t val)
+{
+    var = dtype__mem_refresh(var, sizeof(uint8_t), "dtype_set_uint8");
+    // copy only if size of var is not zero else do nothing
+    var.size ? memcpy(var.mem, &val, sizeof(uint8_t)) : 0;
+    var.type = DTYPE_UINT8;
+    return var;
+}
+
+/// @brief set the value to 16-bit signed integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_int16(dtype var, int16_t val)
+{
+    var = dtype__mem_refresh(var, sizeof(int16_t), "dtype_set_int16");
+    // copy only if size of var is not zero else do nothing
+    var.size ? memcpy(var.mem, &val, sizeof(int16_t)) : 0;
+    var.type = DTYPE_INT16;
+    return var;
+}
+
+/// @brief set the value to 16-bit unsigned integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_uint16(dtype var, uint16_t val)
+{
+    var = dtype__mem_refresh(var, sizeof(uint16_t), "dtype_set_uint16");
+    // copy only if size of var is not zero else do nothing
+    var.size ? memcpy(var.mem, &val, sizeof(uint16_t)) : 0;
+    var.type = DTYPE_UINT16;
+    return var;
+}
+
+/// @brief set the value to 32-bit signed integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_int32(dtype var, int32_t val)
+{
+    var = dtype__mem_refresh(var, sizeof(int32_t), "dtype_set_int32");
+    // copy only if size of var is not zero else do nothing
+    var.size ? memcpy(var.mem, &val, sizeof(int32_t)) : 0;
+    var.type = DTYPE_INT32;
+    return var;
+}
+
+/// @brief set the value to 32-bit unsigned integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_uint32(dtype var, uint32_t val)
+{
+    var = dtype__mem_refresh(var, sizeof(uint32_t), "dtype_set_uint32");
+    // copy only if size of var is not zero else do nothing
+    var.size ? memcpy(var.mem, &val, sizeof(uint32_t)) : 0;
+    var.type = DTYPE_UINT32;
+    return var;
+}
+
+/// @brief set the value to 64-bit signed integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_int64(dtype var, int64_t val)
+{
+    var = dtype__mem_refresh(var, sizeof(int64_t), "dtype_set_int64");
+    // copy only if size of var is not zero else do nothing
+    var.size ? memcpy(var.mem, &val, sizeof(int64_t)) : 0;
+    var.type = DTYPE_INT64;
+    return var;
+}
+
+/// @brief set the value to 64-bit unsigned integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_uint64(dtype var, uint64_t val)
+{
+    var = dtype__mem_refresh(var, sizeof(uint64_t), "dtype_set_uint64");
+    // copy only if size of var is not zero else do nothing
+    var.size ? memcpy(var.mem, &val, sizeof(uint64_t)) : 0;
+    var.type = DTYPE_UINT64;
+    return var;
+}
+
+/// @brief set the value to half precision float [ rounded to nearest even ]
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_float16(dtype var, float val)
+{
+    uint16_t bits = dtype__float_to_half(val);
+    var = dtype__mem_refresh(var, sizeof(uint16_t), "dtype_set_float16");
+    // copy only if size of var is not zero else do nothing
+    var.size ? memcpy(var.mem, &bits, sizeof(uint16_t)) : 0;
+    var.type = DTYPE_FLOAT16;
+    return var;
+}
+
+/// @brief set the value to brain float [ rounded to nearest even ]
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_bfloat16(dtype var, float val)
+{
+    uint16_t bits = dtype__float_to_bfloat(val);
+    var = dtype__mem_refresh(var, sizeof(uint16_t), "dtype_set_bfloat16");
+    // copy only if size of var is not zero else do nothing
+    var.size ? memcpy(var.mem, &bits, sizeof(uint16_t)) : 0;
+    var.type = DTYPE_BFLOAT16;
+    return var;
+}
+
 /// @brief clear the variable, i.e set it to none
 /// @param var the variable to clear
 /// @return the cleared variable
@@ -330,7 +812,10 @@ dtype dtype_clear(dtype var)
 dtype dtype_set_custom(dtype var, void * valPointer, size_t size) {
     var = dtype__mem_refresh(var, size, "dtype_set_custom");
     // copy only if size of var is not zero else do nothing
-    var.size ? memcpy(var.mem, valPointer, size) : 0;
+    if ( var.size ) {
+        memcpy(var.mem, valPointer, size);
+        var.type = DTYPE_CUSTOM;
+    }
     return var;
 }
 
@@ -512,40 +997,3037 @@ char * dtype_get_string(dtype var)
     return ( char * )( var.mem );
 }
 
-/// @brief prints the content of dtype as necessary
-/// @param var the dtype var to print content
-/// @return the value returned by printf when printing the content.
-int dtype_print(dtype var)
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 8-bit signed integer
+int8_t dtype_get_int8(dtype var)
 {
-    switch ( var.type )
-    {
-        case DTYPE_NONE: return printf("none");
-        case DTYPE_BOOL: return printf("%s", dtype_get_bool(var) ? "true" : "false");
-        case DTYPE_CHAR: return printf("%c", dtype_get_char(var));
-        case DTYPE_SHORT: return printf("%hi", dtype_get_short(var));
-        case DTYPE_USHORT: return printf("%hu", dtype_get_ushort(var));
-        case DTYPE_INT: return printf("%d", dtype_get_int(var));
-        case DTYPE_UINT: return printf("%u", dtype_get_uint(var));
-        case DTYPE_LONG: return printf("%ld", dtype_get_long(var));
-        case DTYPE_ULONG: return printf("%lu", dtype_get_ulong(var));
-        case DTYPE_FLOAT: return printf("%f", dtype_get_float(var));
-        case DTYPE_DOUBLE: return printf("%lf", dtype_get_double(var));
-        case DTYPE_STRING: return printf("%s", dtype_get_string(var));
-        case DTYPE_CUSTOM: return printf("dtype_custom_variable");
-        default: return dtype__raise("dtype_print", "Invalid type to print.", DTYPE_TYPE_ERROR);
+    // type mismatch check
+    if ( dtype__typecheck(var, DTYPE_INT8) && DTYPE_WARN_EQ_ERROR ) {
+        dtype__raise(
+            "dtype_get_int8", "All warnings treated as errors, Error produced due to type mismatch.",
+            DTYPE_WARN_ERROR
+        );
     }
+    // return the value
+    return *( (int8_t*) var.mem );
 }
 
-/// @brief debug print of dtype variable
-/// @param var the variable to debug print
-/// @return the value returned by dtype_print when printing the content
-int dtype_debug_print(dtype var)
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 8-bit unsigned integer
+uint8_t dtype_get_uint8(dtype var)
 {
-    if ( var.type < DTYPE_NONE || var.type > DTYPE_CUSTOM ) {
-        return dtype__raise("dtype_debug_print", "Invalid type to print.", DTYPE_TYPE_ERROR);
+    // type mismatch check
+    if ( dtype__typecheck(var, DTYPE_UINT8) && DTYPE_WARN_EQ_ERROR ) {
+        dtype__raise(
+            "dtype_get_uint8", "All warnings treated as errors, Error produced due to type mismatch.",
+            DTYPE_WARN_ERROR
+        );
     }
-    printf("\n{ typecode = %d, type = `%s`, size = `%lu`, content = `", var.type, dtype_get_str_type(var), var.size);
-    int ret = dtype_print(var);
-    printf("` }\n");
-    return ret;
-}
\ No newline at end of file
+    // return the value
+    return *( (uint8_t*) var.mem );
+}
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 16-bit signed integer
+int16_t dtype_get_int16(dtype var)
+{
+    // type mismatch check
+    if ( dtype__typecheck(var, DTYPE_INT16) && DTYPE_WARN_EQ_ERROR ) {
+        dtype__raise(
+            "dtype_get_int16", "All warnings treated as errors, Error produced due to type mismatch.",
+            DTYPE_WARN_ERROR
+        );
+    }
+    // return the value
+    return *( (int16_t*) var.mem );
+}
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 16-bit unsigned integer
+uint16_t dtype_get_uint16(dtype var)
+{
+    // type mismatch check
+    if ( dtype__typecheck(var, DTYPE_UINT16) && DTYPE_WARN_EQ_ERROR ) {
+        dtype__raise(
+            "dtype_get_uint16", "All warnings treated as errors, Error produced due to type mismatch.",
+            DTYPE_WARN_ERROR
+        );
+    }
+    // return the value
+    return *( (uint16_t*) var.mem );
+}
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 32-bit signed integer
+int32_t dtype_get_int32(dtype var)
+{
+    // type mismatch check
+    if ( dtype__typecheck(var, DTYPE_INT32) && DTYPE_WARN_EQ_ERROR ) {
+        dtype__raise(
+            "dtype_get_int32", "All warnings treated as errors, Error produced due to type mismatch.",
+            DTYPE_WARN_ERROR
+        );
+    }
+    // return the value
+    return *( (int32_t*) var.mem );
+}
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 32-bit unsigned integer
+uint32_t dtype_get_uint32(dtype var)
+{
+    // type mismatch check
+    if ( dtype__typecheck(var, DTYPE_UINT32) && DTYPE_WARN_EQ_ERROR ) {
+        dtype__raise(
+            "dtype_get_uint32", "All warnings treated as errors, Error produced due to type mismatch.",
+            DTYPE_WARN_ERROR
+        );
+    }
+    // return the value
+    return *( (uint32_t*) var.mem );
+}
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 64-bit signed integer
+int64_t dtype_get_int64(dtype var)
+{
+    // type mismatch check
+    if ( dtype__typecheck(var, DTYPE_INT64) && DTYPE_WARN_EQ_ERROR ) {
+        dtype__raise(
+            "dtype_get_int64", "All warnings treated as errors, Error produced due to type mismatch.",
+            DTYPE_WARN_ERROR
+        );
+    }
+    // return the value
+    return *( (int64_t*) var.mem );
+}
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 64-bit unsigned integer
+uint64_t dtype_get_uint64(dtype var)
+{
+    // type mismatch check
+    if ( dtype__typecheck(var, DTYPE_UINT64) && DTYPE_WARN_EQ_ERROR ) {
+        dtype__raise(
+            "dtype_get_uint64", "All warnings treated as errors, Error produced due to type mismatch.",
+            DTYPE_WARN_ERROR
+        );
+    }
+    // return the value
+    return *( (uint64_t*) var.mem );
+}
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable (half precision float) widened to float
+float dtype_get_float16(dtype var)
+{
+    // type mismatch check
+    if ( dtype__typecheck(var, DTYPE_FLOAT16) && DTYPE_WARN_EQ_ERROR ) {
+        dtype__raise(
+            "dtype_get_float16", "All warnings treated as errors, Error produced due to type mismatch.",
+            DTYPE_WARN_ERROR
+        );
+    }
+    // return the value
+    return dtype__half_to_float(*( (uint16_t*) var.mem ));
+}
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable (brain float) widened to float
+float dtype_get_bfloat16(dtype var)
+{
+    // type mismatch check
+    if ( dtype__typecheck(var, DTYPE_BFLOAT16) && DTYPE_WARN_EQ_ERROR ) {
+        dtype__raise(
+            "dtype_get_bfloat16", "All warnings treated as errors, Error produced due to type mismatch.",
+            DTYPE_WARN_ERROR
+        );
+    }
+    // return the value
+    return dtype__bfloat_to_float(*( (uint16_t*) var.mem ));
+}
+
+//----------------- Conversion Functions ----------------
+
+/// @brief bulk convert floats to half precision [ uses F16C when the cpu supports it ]
+/// @param dst destination array of `count` half precision values ( as raw 16 bits )
+/// @param src source array of `count` floats
+/// @param count number of elements to convert
+void dtype_float_to_float16(uint16_t * dst, const float * src, size_t count)
+{
+    size_t i = 0;
+#if defined(DTYPE_X86_SIMD)
+    if ( dtype__cpu_has_f16c() ) { i = dtype__float_to_half_f16c(dst, src, count); }
+#endif
+    // scalar tail ( or everything if no simd is available )
+    for ( ; i < count; i++ ) { dst[i] = dtype__float_to_half(src[i]); }
+}
+
+/// @brief bulk convert half precision values to floats [ uses F16C when the cpu supports it ]
+/// @param dst destination array of `count` floats
+/// @param src source array of `count` half precision values ( as raw 16 bits )
+/// @param count number of elements to convert
+void dtype_float16_to_float(float * dst, const uint16_t * src, size_t count)
+{
+    size_t i = 0;
+#if defined(DTYPE_X86_SIMD)
+    if ( dtype__cpu_has_f16c() ) { i = dtype__half_to_float_f16c(dst, src, count); }
+#endif
+    // scalar tail ( or everything if no simd is available )
+    for ( ; i < count; i++ ) { dst[i] = dtype__half_to_float(src[i]); }
+}
+
+/// @brief bulk convert floats to brain floats [ uses AVX2 when the cpu supports it ]
+/// @param dst destination array of `count` brain float values ( as raw 16 bits )
+/// @param src source array of `count` floats
+/// @param count number of elements to convert
+void dtype_float_to_bfloat16(uint16_t * dst, const float * src, size_t count)
+{
+    size_t i = 0;
+#if defined(DTYPE_X86_SIMD)
+    if ( dtype__cpu_has_avx2() ) { i = dtype__float_to_bfloat_avx2(dst, src, count); }
+#endif
+    // scalar tail ( or everything if no simd is available )
+    for ( ; i < count; i++ ) { dst[i] = dtype__float_to_bfloat(src[i]); }
+}
+
+/// @brief bulk convert brain floats to floats [ uses AVX2 when the cpu supports it ]
+/// @param dst destination array of `count` floats
+/// @param src source array of `count` brain float values ( as raw 16 bits )
+/// @param count number of elements to convert
+void dtype_bfloat16_to_float(float * dst, const uint16_t * src, size_t count)
+{
+    size_t i = 0;
+#if defined(DTYPE_X86_SIMD)
+    if ( dtype__cpu_has_avx2() ) { i = dtype__bfloat_to_float_avx2(dst, src, count); }
+#endif
+    // scalar tail ( or everything if no simd is available )
+    for ( ; i < count; i++ ) { dst[i] = dtype__bfloat_to_float(src[i]); }
+}
+
+/// @brief prints the content of dtype as necessary
+/// @param var the dtype var to print content
+/// @return the value returned by printf when printing the content.
+int dtype_print(dtype var)
+{
+    switch ( var.type )
+    {
+        case DTYPE_NONE: return printf("none");
+        case DTYPE_BOOL: return printf("%s", dtype_get_bool(var) ? "true" : "false");
+        case DTYPE_CHAR: return printf("%c", dtype_get_char(var));
+        case DTYPE_SHORT: return printf("%hi", dtype_get_short(var));
+        case DTYPE_USHORT: return printf("%hu", dtype_get_ushort(var));
+        case DTYPE_INT: return printf("%d", dtype_get_int(var));
+        case DTYPE_UINT: return printf("%u", dtype_get_uint(var));
+        case DTYPE_LONG: return printf("%ld", dtype_get_long(var));
+        case DTYPE_ULONG: return printf("%lu", dtype_get_ulong(var));
+        case DTYPE_FLOAT: return printf("%f", dtype_get_float(var));
+        case DTYPE_DOUBLE: return printf("%lf", dtype_get_double(var));
+        case DTYPE_INT8: return printf("%" PRId8, dtype_get_int8(var));
+        case DTYPE_UINT8: return printf("%" PRIu8, dtype_get_uint8(var));
+        case DTYPE_INT16: return printf("%" PRId16, dtype_get_int16(var));
+        case DTYPE_UINT16: return printf("%" PRIu16, dtype_get_uint16(var));
+        case DTYPE_INT32: return printf("%" PRId32, dtype_get_int32(var));
+        case DTYPE_UINT32: return printf("%" PRIu32, dtype_get_uint32(var));
+        case DTYPE_INT64: return printf("%" PRId64, dtype_get_int64(var));
+        case DTYPE_UINT64: return printf("%" PRIu64, dtype_get_uint64(var));
+        case DTYPE_FLOAT16: return printf("%f", dtype_get_float16(var));
+        case DTYPE_BFLOAT16: return printf("%f", dtype_get_bfloat16(var));
+        case DTYPE_STRING: return printf("%s", dtype_get_string(var));
+        case DTYPE_STRING_BUILDER: return (int)fwrite(var.mem, 1, var.length, stdout);
+        case DTYPE_CUSTOM: return printf("dtype_custom_variable");
+        default: return dtype__raise("dtype_print", "Invalid type to print.", DTYPE_TYPE_ERROR);
+    }
+}
+
+/// @brief debug print of dtype variable
+/// @param var the variable to debug print
+/// @return the value returned by dtype_print when printing the content
+int dtype_debug_print(dtype var)
+{
+    if ( var.type < DTYPE_NONE || var.type >= DTYPE_TYPES_END ) {
+        return dtype__raise("dtype_debug_print", "Invalid type to print.", DTYPE_TYPE_ERROR);
+    }
+    printf("\n{ typecode = %d, type = `%s`, size = `%lu`, content = `", var.type, dtype_get_str_type(var), var.size);
+    int ret = dtype_print(var);
+    printf("` }\n");
+    return ret;
+}
+
+// ----------------- Array Functions ----------------
+
+/// @brief check the index is within array, for internal use
+/// @return true if index is out of range [ error is raised ]
+bool dtype__array_index_check(dtype_array arr, size_t index, const char * func)
+{
+    if ( index < arr.length ) { return false; }
+    if ( dtype__raise(func, "Index out of range", DTYPE_INDEX_ERROR) ) {
+        fprintf(stderr, ": %lu >= length %lu\n", index, arr.length);
+    }
+    return true;
+}
+
+/// @brief check the array is a boolean array, for internal use
+/// @return true if array is not boolean [ error is raised ]
+bool dtype__array_bool_check(dtype_array arr, const char * func)
+{
+    if ( arr.type == DTYPE_BOOL ) { return false; }
+    dtype__raise(func, "Boolean array expected.\n", DTYPE_TYPE_ERROR);
+    return true;
+}
+
+/// @brief allocate all valid validity bitmap if not present, for internal use
+/// @return the array with validity bitmap [ unchanged on memory error ]
+dtype_array dtype__array_ensure_valid(dtype_array arr, const char * func)
+{
+    if ( arr.valid != NULL || !arr.length ) { return arr; }
+    size_t words = dtype__bitmap_words(arr.length);
+    arr.valid = malloc(words * sizeof(uint64_t));
+    if ( arr.valid == NULL ) {
+        dtype__mem_error(words * sizeof(uint64_t), func);
+        return arr;
+    }
+    memset(arr.valid, 0xff, words * sizeof(uint64_t));
+    arr.valid[words - 1] &= dtype__bitmap_tail_mask(arr.length);
+    return arr;
+}
+
+/// @brief copy element `from` of `src` into element `to` of `dst` [ same type ], for internal use
+void dtype__array_copy_elem(dtype_array dst, size_t to, dtype_array src, size_t from, size_t size)
+{
+    if ( src.type == DTYPE_BOOL ) {
+        dtype__bit_set(dst.mem, to, dtype__bit_get(src.mem, from));
+    } else {
+        memcpy((char *)dst.mem + to * size, (const char *)src.mem + from * size, size);
+    }
+}
+
+/// @brief get the size of a single element of given type
+/// @param type the type to get size of
+/// @return size in bytes, 0 for types without fixed size ( none, string, custom )
+size_t dtype_type_size(enum DTYPE_TYPES type)
+{
+    switch ( type )
+    {
+        case DTYPE_BOOL: return sizeof(bool);
+        case DTYPE_CHAR: return sizeof(char);
+        case DTYPE_SHORT: return sizeof(short);
+        case DTYPE_USHORT: return sizeof(unsigned short);
+        case DTYPE_INT: return sizeof(int);
+        case DTYPE_UINT: return sizeof(unsigned int);
+        case DTYPE_LONG: return sizeof(long);
+        case DTYPE_ULONG: return sizeof(unsigned long);
+        case DTYPE_FLOAT: return sizeof(float);
+        case DTYPE_DOUBLE: return sizeof(double);
+        case DTYPE_INT8: case DTYPE_UINT8: return 1;
+        case DTYPE_INT16: case DTYPE_UINT16: return 2;
+        case DTYPE_INT32: case DTYPE_UINT32: return 4;
+        case DTYPE_INT64: case DTYPE_UINT64: return 8;
+        case DTYPE_FLOAT16: case DTYPE_BFLOAT16: return sizeof(uint16_t);
+        default: return 0;
+    }
+}
+
+/// @brief Returns a null, but initialized dtype array
+/// @return initialized dtype array
+dtype_array dtype_array_default()
+{
+    dtype_array arr;
+    arr.mem = NULL;
+    arr.valid = NULL;
+    arr.length = 0;
+    arr.type = DTYPE_NONE;
+    return arr;
+}
+
+/// @brief create a zero filled array of given type and length [ booleans are bit-packed ]
+/// @param type the type of elements, must have a fixed size ( see dtype_type_size ) or be DTYPE_BOOL
+/// @param length number of elements
+/// @return the created array, or default array on error
+dtype_array dtype_array_new(enum DTYPE_TYPES type, size_t length)
+{
+    dtype_array arr = dtype_array_default();
+    size_t size = dtype_type_size(type);
+    if ( !size ) {
+        if ( dtype__raise("dtype_array_new", "Type can't be stored in an array", DTYPE_TYPE_ERROR) ) {
+            fprintf(stderr, ": `%s`\n", DTYPE_STR_TYPES[type]);
+        }
+        return arr;
+    }
+    size = type == DTYPE_BOOL ? dtype__bitmap_words(length) * sizeof(uint64_t) : size * length;
+    arr.mem = size ? dtype__mem_alloc(size) : NULL;
+    if ( size && arr.mem == NULL ) {
+        dtype__mem_error(size, "dtype_array_new");
+        return arr;
+    }
+    arr.length = length;
+    arr.type = type;
+    return arr;
+}
+
+/// @brief clear the array, i.e free elements & validity bitmap
+/// @param arr the array to clear
+/// @return the cleared array
+dtype_array dtype_array_clear(dtype_array arr)
+{
+    free(arr.mem);
+    free(arr.valid);
+    return dtype_array_default();
+}
+
+/// @brief mark the element at index valid or null
+/// @param arr the array to mark in
+/// @param index the index of element
+/// @param valid false to mark as null
+/// @return the array with validity as given [ validity bitmap gets allocated on first null ]
+dtype_array dtype_array_set_valid(dtype_array arr, size_t index, bool valid)
+{
+    if ( dtype__array_index_check(arr, index, "dtype_array_set_valid") ) { return arr; }
+    // everything is valid already when there is no bitmap
+    if ( valid && arr.valid == NULL ) { return arr; }
+    arr = dtype__array_ensure_valid(arr, "dtype_array_set_valid");
+    arr.valid ? dtype__bit_set(arr.valid, index, valid) : (void)0;
+    return arr;
+}
+
+/// @brief check if element at index is valid ( not null )
+/// @param arr the array to check in
+/// @param index the index of element
+/// @return true if element is valid
+bool dtype_array_is_valid(dtype_array arr, size_t index)
+{
+    if ( dtype__array_index_check(arr, index, "dtype_array_is_valid") ) { return false; }
+    return arr.valid == NULL || dtype__bit_get(arr.valid, index);
+}
+
+/// @brief set the value of element at index [ a DTYPE_NONE value marks the element as null ]
+/// @param arr the array to set in
+/// @param index the index of element
+/// @param val the value to set to, must be of the same type as the array
+/// @return the array with value as given [ validity bitmap may get allocated ]
+dtype_array dtype_array_set(dtype_array arr, size_t index, dtype val)
+{
+    if ( val.type == DTYPE_NONE ) { return dtype_array_set_valid(arr, index, false); }
+    if ( dtype__array_index_check(arr, index, "dtype_array_set") ) { return arr; }
+    size_t size = dtype_type_size(arr.type);
+    if ( val.type != arr.type || val.size < size ) {
+        if ( dtype__raise("dtype_array_set", "Type mismatch while setting", DTYPE_TYPE_ERROR) ) {
+            fprintf(stderr, ": `%s` into array of `%s`\n", dtype_get_str_type(val), DTYPE_STR_TYPES[arr.type]);
+        }
+        return arr;
+    }
+    if ( arr.type == DTYPE_BOOL ) {
+        dtype__bit_set(arr.mem, index, *( (bool*) val.mem ));
+    } else {
+        memcpy((char *)arr.mem + index * size, val.mem, size);
+    }
+    return dtype_array_set_valid(arr, index, true);
+}
+
+/// @brief get the value of element at index
+/// @param arr the array to get from
+/// @param index the index of element
+/// @param var the dtype variable to store value in
+/// @return the dtype variable with value of element, or cleared variable if element is null
+dtype dtype_array_get(dtype_array arr, size_t index, dtype var)
+{
+    if ( !dtype_array_is_valid(arr, index) ) { return dtype_clear(var); }
+    if ( arr.type == DTYPE_BOOL ) { return dtype_set_bool(var, dtype__bit_get(arr.mem, index)); }
+    size_t size = dtype_type_size(arr.type);
+    var = dtype__mem_refresh(var, size, "dtype_array_get");
+    // copy only if size of var is not zero else do nothing
+    var.size ? memcpy(var.mem, (const char *)arr.mem + index * size, size) : 0;
+    var.type = var.size ? arr.type : DTYPE_NONE;
+    return var;
+}
+
+/// @brief count the null elements in array [ popcount of the validity bitmap ]
+/// @param arr the array to count in
+/// @return number of null elements
+size_t dtype_array_null_count(dtype_array arr)
+{
+    size_t words = dtype__bitmap_words(arr.length);
+    if ( arr.valid == NULL || !words ) { return 0; }
+    // bits past the length are not counted, whoever left them set
+    uint64_t tail = arr.valid[words - 1] & dtype__bitmap_tail_mask(arr.length);
+    return arr.length - dtype__bitmap_popcount(arr.valid, NULL, words - 1) - dtype__popcount64(tail);
+}
+
+/// @brief count the elements of a boolean array which are valid and true
+/// @param mask the boolean array to count in
+/// @return number of valid true elements
+size_t dtype_array_count_true(dtype_array mask)
+{
+    if ( dtype__array_bool_check(mask, "dtype_array_count_true") ) { return 0; }
+    size_t words = dtype__bitmap_words(mask.length);
+    if ( !words ) { return 0; }
+    // bits past the length may be garbage after a not, keep them out of the count
+    uint64_t tail = ((uint64_t *)mask.mem)[words - 1] & dtype__bitmap_tail_mask(mask.length);
+    if ( mask.valid ) { tail &= mask.valid[words - 1]; }
+    return dtype__bitmap_popcount(mask.mem, mask.valid, words - 1) + dtype__popcount64(tail);
+}
+
+/// @brief combine two boolean arrays with bitmap op, for internal use
+dtype_array dtype__array_mask_op(dtype_array a, dtype_array b, int op, const char * func)
+{
+    if ( dtype__array_bool_check(a, func) || dtype__array_bool_check(b, func) ) {
+        return dtype_array_default();
+    }
+    if ( a.length != b.length ) {
+        dtype__raise(func, "Arrays must be of same length.\n", DTYPE_INDEX_ERROR);
+        return dtype_array_default();
+    }
+    dtype_array out = dtype_array_new(DTYPE_BOOL, a.length);
+    size_t words = dtype__bitmap_words(a.length);
+    if ( out.mem == NULL ) { return out; }
+    dtype__bitmap_op(out.mem, a.mem, b.mem, words, op);
+    // result is null where either input is null
+    if ( a.valid || b.valid ) {
+        out = dtype__array_ensure_valid(out, func);
+        if ( out.valid == NULL ) { return out; }
+        if ( a.valid && b.valid ) {
+            dtype__bitmap_op(out.valid, a.valid, b.valid, words, 0);
+        } else {
+            memcpy(out.valid, a.valid ? a.valid : b.valid, words * sizeof(uint64_t));
+        }
+    }
+    return out;
+}
+
+/// @brief element-wise and of two boolean arrays [ null if either is null ]
+/// @param a first boolean array
+/// @param b second boolean array, of same length
+/// @return new boolean array with the result
+dtype_array dtype_array_mask_and(dtype_array a, dtype_array b)
+{
+    return dtype__array_mask_op(a, b, 0, "dtype_array_mask_and");
+}
+
+/// @brief element-wise or of two boolean arrays [ null if either is null ]
+/// @param a first boolean array
+/// @param b second boolean array, of same length
+/// @return new boolean array with the result
+dtype_array dtype_array_mask_or(dtype_array a, dtype_array b)
+{
+    return dtype__array_mask_op(a, b, 1, "dtype_array_mask_or");
+}
+
+/// @brief element-wise not of a boolean array [ nulls stay null ]
+/// @param a the boolean array
+/// @return new boolean array with the result
+dtype_array dtype_array_mask_not(dtype_array a)
+{
+    dtype_array out = dtype__array_mask_op(a, a, 2, "dtype_array_mask_not");
+    size_t words = dtype__bitmap_words(out.length);
+    // keep the bits past the length cleared
+    words ? ((uint64_t *)out.mem)[words - 1] &= dtype__bitmap_tail_mask(out.length) : 0;
+    return out;
+}
+
+/// @brief keep only the elements for which mask is valid and true
+/// @param arr the array to filter
+/// @param mask boolean array of same length
+/// @return new array with the kept elements [ validity of kept elements is preserved ]
+dtype_array dtype_array_filter(dtype_array arr, dtype_array mask)
+{
+    if ( dtype__array_bool_check(mask, "dtype_array_filter") ) { return dtype_array_default(); }
+    if ( arr.length != mask.length ) {
+        dtype__raise("dtype_array_filter", "Arrays must be of same length.\n", DTYPE_INDEX_ERROR);
+        return dtype_array_default();
+    }
+    size_t count = dtype_array_count_true(mask);
+    dtype_array out = dtype_array_new(arr.type, count);
+    if ( count && out.mem == NULL ) { return out; }
+    size_t size = dtype_type_size(arr.type);
+    size_t words = dtype__bitmap_words(mask.length);
+    size_t j = 0;
+    for ( size_t k = 0; k < words && j < count; k++ ) {
+        uint64_t bits = ((const uint64_t *)mask.mem)[k] & (mask.valid ? mask.valid[k] : ~(uint64_t)0);
+        bits &= k + 1 == words ? dtype__bitmap_tail_mask(mask.length) : ~(uint64_t)0;
+        // walk only the set bits, cheap for sparse masks
+        while ( bits && j < count ) {
+            size_t i = k * 64 + dtype__ctz64(bits);
+            dtype__array_copy_elem(out, j, arr, i, size);
+            if ( arr.valid && !dtype__bit_get(arr.valid, i) ) {
+                out = dtype_array_set_valid(out, j, false);
+            }
+            j++;
+            bits &= bits - 1;
+        }
+    }
+    return out;
+}
+
+/// @brief pick elements from `a` where mask is valid and true, else from `b`
+/// @param mask boolean array
+/// @param a array to pick from where mask is true
+/// @param b array to pick from otherwise, of same type & length as `a`
+/// @return new array with the picked elements [ validity is picked along with values ]
+dtype_array dtype_array_select(dtype_array mask, dtype_array a, dtype_array b)
+{
+    if ( dtype__array_bool_check(mask, "dtype_array_select") ) { return dtype_array_default(); }
+    if ( a.type != b.type ) {
+        dtype__raise("dtype_array_select", "Arrays must be of same type.\n", DTYPE_TYPE_ERROR);
+        return dtype_array_default();
+    }
+    if ( a.length != mask.length || b.length != mask.length ) {
+        dtype__raise("dtype_array_select", "Arrays must be of same length.\n", DTYPE_INDEX_ERROR);
+        return dtype_array_default();
+    }
+    dtype_array out = dtype_array_new(a.type, a.length);
+    if ( out.mem == NULL ) { return out; }
+    if ( a.valid || b.valid ) {
+        out = dtype__array_ensure_valid(out, "dtype_array_select");
+        if ( out.valid == NULL ) { return out; }
+    }
+    size_t size = dtype_type_size(a.type);
+    size_t words = dtype__bitmap_words(a.length);
+    const uint64_t all = ~(uint64_t)0;
+    for ( size_t k = 0; k < words; k++ ) {
+        uint64_t pick = ((const uint64_t *)mask.mem)[k] & (mask.valid ? mask.valid[k] : all);
+        if ( out.valid ) {
+            uint64_t av = a.valid ? a.valid[k] : all;
+            uint64_t bv = b.valid ? b.valid[k] : all;
+            out.valid[k] = ((av & pick) | (bv & ~pick)) & (k + 1 == words ? dtype__bitmap_tail_mask(a.length) : all);
+        }
+        if ( a.type == DTYPE_BOOL ) {
+            ((uint64_t *)out.mem)[k] = (((const uint64_t *)a.mem)[k] & pick) | (((const uint64_t *)b.mem)[k] & ~pick);
+            continue;
+        }
+        size_t start = k * 64;
+        size_t end = start + 64 < a.length ? start + 64 : a.length;
+        // whole word from one side is a single copy
+        if ( (pick & dtype__bitmap_tail_mask(end - start)) == dtype__bitmap_tail_mask(end - start) || !pick ) {
+            memcpy((char *)out.mem + start * size, (const char *)(pick ? a.mem : b.mem) + start * size, (end - start) * size);
+            continue;
+        }
+        for ( size_t i = start; i < end; i++ ) {
+            dtype__array_copy_elem(out, i, (pick >> (i - start)) & 1 ? a : b, i, size);
+        }
+    }
+    return out;
+}
+
+/// @brief prints the content of dtype array as a list
+/// @param arr the array to print
+/// @return the number of characters printed
+int dtype_array_print(dtype_array arr)
+{
+    dtype var = dtype_default();
+    int ret = printf("[");
+    for ( size_t i = 0; i < arr.length; i++ ) {
+        var = dtype_array_get(arr, i, var);
+        ret += i ? printf(", ") : 0;
+        ret += dtype_print(var);
+    }
+    ret += printf("]");
+    dtype_clear(var);
+    return ret;
+}
+
+// ----------------- Codec Functions ----------------
+
+/// @brief size of an encoded block header : codec, type, flags, 5 reserved bytes & 64-bit length
+#define DTYPE__BLOCK_HEADER 16
+/// @brief number of values bit-packed together with a single width
+#define DTYPE__BLOCK_VALUES 128
+
+/// @brief check if type is an integer type, for internal use
+bool dtype__type_is_integer(enum DTYPE_TYPES type)
+{
+    switch ( type )
+    {
+        case DTYPE_CHAR: case DTYPE_SHORT: case DTYPE_USHORT: case DTYPE_INT: case DTYPE_UINT:
+        case DTYPE_LONG: case DTYPE_ULONG: case DTYPE_INT8: case DTYPE_UINT8: case DTYPE_INT16:
+        case DTYPE_UINT16: case DTYPE_INT32: case DTYPE_UINT32: case DTYPE_INT64: case DTYPE_UINT64:
+            return true;
+        default: return false;
+    }
+}
+
+/// @brief check if type is a signed integer type, for internal use
+bool dtype__type_is_signed(enum DTYPE_TYPES type)
+{
+    switch ( type )
+    {
+        case DTYPE_CHAR: return (char)-1 < 0;
+        case DTYPE_SHORT: case DTYPE_INT: case DTYPE_LONG:
+        case DTYPE_INT8: case DTYPE_INT16: case DTYPE_INT32: case DTYPE_INT64:
+            return true;
+        default: return false;
+    }
+}
+
+/// @brief raise error for invalid encoded data, for internal use
+void dtype__format_error(const char * func)
+{
+    dtype__raise(func, "Invalid or corrupted encoded block.\n", DTYPE_FORMAT_ERROR);
+}
+
+/// @brief load `count` elements from `start` widened to 64 bits [ sign extended if `sign` ], for internal use
+void dtype__load_block(uint64_t * vals, const void * mem, size_t start, size_t count, size_t size, bool sign)
+{
+    const char * p = (const char *)mem + start * size;
+    switch ( size )
+    {
+        case 1:
+            for ( size_t i = 0; i < count; i++ ) {
+                uint8_t v = (uint8_t)p[i];
+                vals[i] = sign ? (uint64_t)(int64_t)(int8_t)v : v;
+            }
+            break;
+        case 2:
+            for ( size_t i = 0; i < count; i++ ) {
+                uint16_t v;
+                memcpy(&v, p + i * 2, 2);
+                vals[i] = sign ? (uint64_t)(int64_t)(int16_t)v : v;
+            }
+            break;
+        case 4:
+            for ( size_t i = 0; i < count; i++ ) {
+                uint32_t v;
+                memcpy(&v, p + i * 4, 4);
+                vals[i] = sign ? (uint64_t)(int64_t)(int32_t)v : v;
+            }
+            break;
+        default:
+            memcpy(vals, p, count * 8);
+            break;
+    }
+}
+
+/// @brief store `count` 64-bit values truncated to element size at `start`, for internal use
+void dtype__store_block(void * mem, size_t start, const uint64_t * vals, size_t count, size_t size)
+{
+    char * p = (char *)mem + start * size;
+    switch ( size )
+    {
+        case 1: for ( size_t i = 0; i < count; i++ ) { p[i] = (char)(uint8_t)vals[i]; } break;
+        case 2: for ( size_t i = 0; i < count; i++ ) { ((uint16_t *)p)[i] = (uint16_t)vals[i]; } break;
+        case 4: for ( size_t i = 0; i < count; i++ ) { ((uint32_t *)p)[i] = (uint32_t)vals[i]; } break;
+        default: memcpy(p, vals, count * 8); break;
+    }
+}
+
+/// @brief number of significant bits of a 64-bit value, for internal use
+unsigned dtype__bit_width(uint64_t x)
+{
+    unsigned width = 0;
+    while ( x ) { x >>= 1; width++; }
+    return width;
+}
+
+/// @brief bit-pack values of given width [ little endian bit order ], for internal use
+/// @return number of bytes written, i.e ceil(count * width / 8)
+size_t dtype__bitpack(unsigned char * dst, const uint64_t * vals, size_t count, unsigned width)
+{
+    if ( !width ) { return 0; }
+    unsigned char * start = dst;
+    uint64_t acc = 0;
+    unsigned fill = 0;
+    for ( size_t i = 0; i < count; i++ ) {
+        acc |= vals[i] << fill;
+        if ( fill + width >= 64 ) {
+            memcpy(dst, &acc, 8);
+            dst += 8;
+            acc = fill ? vals[i] >> (64 - fill) : 0;
+            fill = fill + width - 64;
+        } else {
+            fill += width;
+        }
+    }
+    memcpy(dst, &acc, (fill + 7) / 8);
+    return (size_t)(dst - start) + (fill + 7) / 8;
+}
+
+/// @brief unpack values of given width from `bytes` bytes of bit-packed data, for internal use
+void dtype__bitunpack(uint64_t * vals, const unsigned char * src, size_t bytes, size_t count, unsigned width)
+{
+    if ( !width ) {
+        memset(vals, 0, count * sizeof(uint64_t));
+        return;
+    }
+    uint64_t mask = width == 64 ? ~(uint64_t)0 : ((uint64_t)1 << width) - 1;
+    size_t i = 0;
+    // fixed 8 + 1 byte loads while they stay within the packed data
+    for ( ; i < count && (i * width) / 8 + 9 <= bytes; i++ ) {
+        size_t bit = i * width;
+        uint64_t lo;
+        memcpy(&lo, src + bit / 8, 8);
+        uint64_t val = lo >> (bit % 8);
+        if ( bit % 8 + width > 64 ) { val |= (uint64_t)src[bit / 8 + 8] << (64 - bit % 8); }
+        vals[i] = val & mask;
+    }
+    for ( ; i < count; i++ ) {
+        size_t bit = i * width;
+        size_t at = bit / 8;
+        unsigned shift = bit % 8;
+        uint64_t lo = 0;
+        memcpy(&lo, src + at, bytes - at < 8 ? bytes - at : 8);
+        uint64_t val = lo >> shift;
+        // value straddles past the 8 loaded bytes
+        if ( shift + width > 64 ) { val |= (uint64_t)src[at + 8] << (64 - shift); }
+        vals[i] = val & mask;
+    }
+}
+
+/// @brief encode a block of widened values [ `vals` are overwritten ], for internal use
+/// @return number of bytes written
+size_t dtype__encode_block(unsigned char * dst, uint64_t * vals, size_t count, enum DTYPE_CODECS codec, bool sign, uint64_t * prev)
+{
+    unsigned char * start = dst;
+    uint64_t bits = 0;
+    if ( codec == DTYPE_CODEC_DELTA ) {
+        for ( size_t i = 0; i < count; i++ ) {
+            uint64_t delta = vals[i] - *prev;
+            *prev = vals[i];
+            // zigzag so small negative deltas stay small
+            vals[i] = (delta << 1) ^ (uint64_t)((int64_t)delta >> 63);
+            bits |= vals[i];
+        }
+        *dst++ = (unsigned char)dtype__bit_width(bits);
+    } else if ( codec == DTYPE_CODEC_FOR ) {
+        uint64_t base = vals[0];
+        for ( size_t i = 1; i < count; i++ ) {
+            if ( sign ? (int64_t)vals[i] < (int64_t)base : vals[i] < base ) { base = vals[i]; }
+        }
+        for ( size_t i = 0; i < count; i++ ) {
+            vals[i] -= base;
+            bits |= vals[i];
+        }
+        memcpy(dst, &base, 8);
+        dst += 8;
+        *dst++ = (unsigned char)dtype__bit_width(bits);
+    } else {
+        for ( size_t i = 0; i < count; i++ ) {
+            uint64_t x = vals[i] ^ *prev;
+            *prev = vals[i];
+            vals[i] = x;
+            bits |= x;
+        }
+        // drop the trailing zero bits common to the whole block
+        unsigned shift = bits ? (unsigned)dtype__ctz64(bits) : 0;
+        for ( size_t i = 0; shift && i < count; i++ ) { vals[i] >>= shift; }
+        *dst++ = (unsigned char)shift;
+        *dst++ = (unsigned char)dtype__bit_width(bits >> shift);
+    }
+    dst += dtype__bitpack(dst, vals, count, dst[-1]);
+    return (size_t)(dst - start);
+}
+
+#if defined(DTYPE_X86_SIMD)
+
+/// @brief AVX2 kernel for zigzag decode & prefix sum of deltas, returns number of values done
+__attribute__((target("avx2")))
+size_t dtype__decode_delta_avx2(uint64_t * vals, size_t count, uint64_t * prev)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi64x(1);
+    __m256i carry = _mm256_set1_epi64x((long long)*prev);
+    size_t i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(vals + i));
+        v = _mm256_xor_si256(_mm256_srli_epi64(v, 1), _mm256_sub_epi64(zero, _mm256_and_si256(v, one)));
+        // in register prefix sum : shift by one lane then by two lanes
+        v = _mm256_add_epi64(v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x90), zero, 0x03));
+        v = _mm256_add_epi64(v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x40), zero, 0x0F));
+        v = _mm256_add_epi64(v, carry);
+        _mm256_storeu_si256((__m256i *)(vals + i), v);
+        carry = _mm256_permute4x64_epi64(v, 0xFF);
+    }
+    if ( i ) { *prev = vals[i - 1]; }
+    return i;
+}
+
+/// @brief AVX2 kernel adding frame of reference base, returns number of values done
+__attribute__((target("avx2")))
+size_t dtype__decode_for_avx2(uint64_t * vals, size_t count, uint64_t base)
+{
+    const __m256i vbase = _mm256_set1_epi64x((long long)base);
+    size_t i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(vals + i));
+        _mm256_storeu_si256((__m256i *)(vals + i), _mm256_add_epi64(v, vbase));
+    }
+    return i;
+}
+
+/// @brief AVX2 kernel for shift & prefix xor, returns number of values done
+__attribute__((target("avx2")))
+size_t dtype__decode_xor_avx2(uint64_t * vals, size_t count, unsigned shift, uint64_t * prev)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m128i vshift = _mm_cvtsi32_si128((int)shift);
+    __m256i carry = _mm256_set1_epi64x((long long)*prev);
+    size_t i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        __m256i v = _mm256_sll_epi64(_mm256_loadu_si256((const __m256i *)(vals + i)), vshift);
+        // in register prefix xor : shift by one lane then by two lanes
+        v = _mm256_xor_si256(v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x90), zero, 0x03));
+        v = _mm256_xor_si256(v, _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x40), zero, 0x0F));
+        v = _mm256_xor_si256(v, carry);
+        _mm256_storeu_si256((__m256i *)(vals + i), v);
+        carry = _mm256_permute4x64_epi64(v, 0xFF);
+    }
+    if ( i ) { *prev = vals[i - 1]; }
+    return i;
+}
+
+#endif // DTYPE_X86_SIMD
+
+/// @brief decode a block into widened values, for internal use
+/// @return number of bytes consumed, 0 if block is invalid
+size_t dtype__decode_block(uint64_t * vals, const unsigned char * src, const unsigned char * end, size_t count, enum DTYPE_CODECS codec, uint64_t * prev)
+{
+    const unsigned char * start = src;
+    size_t head = codec == DTYPE_CODEC_FOR ? 9 : ( codec == DTYPE_CODEC_XOR ? 2 : 1 );
+    if ( (size_t)(end - src) < head ) { return 0; }
+    uint64_t base = 0;
+    unsigned shift = 0;
+    if ( codec == DTYPE_CODEC_FOR ) { memcpy(&base, src, 8); src += 8; }
+    if ( codec == DTYPE_CODEC_XOR ) { shift = *src++; }
+    unsigned width = *src++;
+    if ( width > 64 || shift + width > 64 ) { return 0; }
+    size_t bytes = (count * width + 7) / 8;
+    if ( (size_t)(end - src) < bytes ) { return 0; }
+    dtype__bitunpack(vals, src, bytes, count, width);
+    size_t i = 0;
+    if ( codec == DTYPE_CODEC_DELTA ) {
+#if defined(DTYPE_X86_SIMD)
+        if ( dtype__cpu_has_avx2() ) { i = dtype__decode_delta_avx2(vals, count, prev); }
+#endif
+        for ( ; i < count; i++ ) {
+            *prev += (vals[i] >> 1) ^ (~(vals[i] & 1) + 1);
+            vals[i] = *prev;
+        }
+    } else if ( codec == DTYPE_CODEC_FOR ) {
+#if defined(DTYPE_X86_SIMD)
+        if ( dtype__cpu_has_avx2() ) { i = dtype__decode_for_avx2(vals, count, base); }
+#endif
+        for ( ; i < count; i++ ) { vals[i] += base; }
+    } else {
+#if defined(DTYPE_X86_SIMD)
+        if ( dtype__cpu_has_avx2() ) { i = dtype__decode_xor_avx2(vals, count, shift, prev); }
+#endif
+        for ( ; i < count; i++ ) {
+            *prev ^= vals[i] << shift;
+            vals[i] = *prev;
+        }
+    }
+    return (size_t)(src - start) + bytes;
+}
+
+/// @brief write block header, for internal use
+/// @return pointer past the header
+unsigned char * dtype__write_header(unsigned char * dst, enum DTYPE_CODECS codec, enum DTYPE_TYPES type, bool has_valid, uint64_t length)
+{
+    memset(dst, 0, DTYPE__BLOCK_HEADER);
+    dst[0] = (unsigned char)codec;
+    dst[1] = (unsigned char)type;
+    dst[2] = has_valid ? 1 : 0;
+    memcpy(dst + 8, &length, 8);
+    return dst + DTYPE__BLOCK_HEADER;
+}
+
+/// @brief shrink the encoded output to the used size, for internal use
+dtype dtype__encode_finish(dtype out, size_t used)
+{
+    void * mem = realloc(out.mem, used);
+    out.mem = mem ? mem : out.mem;
+    out.size = used;
+    out.type = DTYPE_CUSTOM;
+    return out;
+}
+
+/// @brief get the codec used for given type by DTYPE_CODEC_AUTO
+/// @param type the type of column
+/// @return delta for integers, xor for float & double, dict rle for string, raw for the rest
+enum DTYPE_CODECS dtype_codec_for_type(enum DTYPE_TYPES type)
+{
+    if ( dtype__type_is_integer(type) ) { return DTYPE_CODEC_DELTA; }
+    if ( type == DTYPE_FLOAT || type == DTYPE_DOUBLE ) { return DTYPE_CODEC_XOR; }
+    if ( type == DTYPE_STRING ) { return DTYPE_CODEC_DICT_RLE; }
+    return DTYPE_CODEC_RAW;
+}
+
+/// @brief check codec can encode values of type, for internal use
+bool dtype__codec_suits(enum DTYPE_CODECS codec, enum DTYPE_TYPES type)
+{
+    return codec == DTYPE_CODEC_RAW
+        || ( (codec == DTYPE_CODEC_DELTA || codec == DTYPE_CODEC_FOR) && dtype__type_is_integer(type) )
+        || ( codec == DTYPE_CODEC_XOR && (type == DTYPE_FLOAT || type == DTYPE_DOUBLE) );
+}
+
+/// @brief encode an array into a self describing block [ validity bitmap is kept ]
+/// @param arr the array to encode
+/// @param codec the codec to use, must suit the type of array
+/// @param out the dtype variable to store the encoded bytes in
+/// @return the dtype variable ( DTYPE_CUSTOM ) with the encoded block, or cleared variable on error
+dtype dtype_array_encode(dtype_array arr, enum DTYPE_CODECS codec, dtype out)
+{
+    size_t size = dtype_type_size(arr.type);
+    codec = codec == DTYPE_CODEC_AUTO ? dtype_codec_for_type(arr.type) : codec;
+    if ( !size || !dtype__codec_suits(codec, arr.type) ) {
+        if ( dtype__raise("dtype_array_encode", "Codec doesn't suit the type of array", DTYPE_TYPE_ERROR) ) {
+            fprintf(stderr, ": codec `%d` for `%s`\n", codec, DTYPE_STR_TYPES[arr.type]);
+        }
+        return dtype_clear(out);
+    }
+    size_t words = dtype__bitmap_words(arr.length);
+    size_t raw = arr.type == DTYPE_BOOL ? words * sizeof(uint64_t) : arr.length * size;
+    size_t blocks = (arr.length + DTYPE__BLOCK_VALUES - 1) / DTYPE__BLOCK_VALUES;
+    // worst case : every block header at its largest & every value at 64 bits
+    size_t bound = DTYPE__BLOCK_HEADER + (arr.valid ? words * sizeof(uint64_t) : 0)
+        + (codec == DTYPE_CODEC_RAW ? raw : blocks * 9 + arr.length * 8);
+    out = dtype__mem_refresh(out, bound, "dtype_array_encode");
+    if ( !out.size ) { return out; }
+    unsigned char * p = dtype__write_header(out.mem, codec, arr.type, arr.valid != NULL, arr.length);
+    if ( arr.valid ) {
+        memcpy(p, arr.valid, words * sizeof(uint64_t));
+        p += words * sizeof(uint64_t);
+    }
+    if ( codec == DTYPE_CODEC_RAW ) {
+        raw ? memcpy(p, arr.mem, raw) : 0;
+        return dtype__encode_finish(out, (size_t)(p - (unsigned char *)out.mem) + raw);
+    }
+    uint64_t vals[DTYPE__BLOCK_VALUES];
+    uint64_t prev = 0;
+    bool sign = dtype__type_is_signed(arr.type);
+    for ( size_t start = 0; start < arr.length; start += DTYPE__BLOCK_VALUES ) {
+        size_t count = arr.length - start < DTYPE__BLOCK_VALUES ? arr.length - start : DTYPE__BLOCK_VALUES;
+        dtype__load_block(vals, arr.mem, start, count, size, sign);
+        p += dtype__encode_block(p, vals, count, codec, sign, &prev);
+    }
+    return dtype__encode_finish(out, (size_t)(p - (unsigned char *)out.mem));
+}
+
+/// @brief decode a block created by dtype_array_encode [ uses AVX2 when the cpu supports it ]
+/// @param mem pointer to the encoded block
+/// @param size size of the encoded block
+/// @return the decoded array, or default array on error
+dtype_array dtype_array_decode(const void * mem, size_t size)
+{
+    const unsigned char * p = mem;
+    const unsigned char * end = p + size;
+    if ( size < DTYPE__BLOCK_HEADER ) {
+        dtype__format_error("dtype_array_decode");
+        return dtype_array_default();
+    }
+    enum DTYPE_CODECS codec = (enum DTYPE_CODECS)p[0];
+    enum DTYPE_TYPES type = (enum DTYPE_TYPES)p[1];
+    bool has_valid = p[2] & 1;
+    uint64_t length;
+    memcpy(&length, p + 8, 8);
+    p += DTYPE__BLOCK_HEADER;
+    size_t esize = dtype_type_size(type);
+    size_t words = dtype__bitmap_words(length);
+    size_t raw = type == DTYPE_BOOL ? words * sizeof(uint64_t) : length * esize;
+    size_t blocks = (length + DTYPE__BLOCK_VALUES - 1) / DTYPE__BLOCK_VALUES;
+    size_t left = (size_t)(end - p);
+    // reject before allocating anything when the sizes can't be right
+    if ( !esize || !dtype__codec_suits(codec, type) || length > left * DTYPE__BLOCK_VALUES
+        || (has_valid && words * sizeof(uint64_t) > left)
+        || (codec == DTYPE_CODEC_RAW && raw + (has_valid ? words * sizeof(uint64_t) : 0) > left)
+        || (codec != DTYPE_CODEC_RAW && blocks > left) ) {
+        dtype__format_error("dtype_array_decode");
+        return dtype_array_default();
+    }
+    // bits past the length must be clear, arrays rely on it
+    uint64_t tail = 0;
+    if ( has_valid && words ) { memcpy(&tail, p + (words - 1) * sizeof(uint64_t), sizeof(uint64_t)); }
+    if ( type == DTYPE_BOOL && codec == DTYPE_CODEC_RAW && words ) {
+        uint64_t last;
+        const unsigned char * bools = p + (has_valid ? words * sizeof(uint64_t) : 0);
+        memcpy(&last, bools + (words - 1) * sizeof(uint64_t), sizeof(uint64_t));
+        tail |= last;
+    }
+    if ( tail & ~dtype__bitmap_tail_mask(length) ) {
+        dtype__format_error("dtype_array_decode");
+        return dtype_array_default();
+    }
+    dtype_array arr = dtype_array_new(type, length);
+    if ( length && arr.mem == NULL ) { return arr; }
+    if ( has_valid ) {
+        arr = dtype__array_ensure_valid(arr, "dtype_array_decode");
+        if ( arr.valid == NULL ) { return dtype_array_clear(arr); }
+        memcpy(arr.valid, p, words * sizeof(uint64_t));
+        p += words * sizeof(uint64_t);
+    }
+    if ( codec == DTYPE_CODEC_RAW ) {
+        raw ? memcpy(arr.mem, p, raw) : 0;
+        return arr;
+    }
+    uint64_t vals[DTYPE__BLOCK_VALUES];
+    uint64_t prev = 0;
+    for ( size_t start = 0; start < length; start += DTYPE__BLOCK_VALUES ) {
+        size_t count = length - start < DTYPE__BLOCK_VALUES ? length - start : DTYPE__BLOCK_VALUES;
+        size_t used = dtype__decode_block(vals, p, end, count, codec, &prev);
+        if ( !used ) {
+            dtype__format_error("dtype_array_decode");
+            return dtype_array_clear(arr);
+        }
+        dtype__store_block(arr.mem, start, vals, count, esize);
+        p += used;
+    }
+    return arr;
+}
+
+/// @brief number of bytes needed to write value as varint, for internal use
+size_t dtype__varint_size(uint64_t val)
+{
+    size_t size = 1;
+    while ( val >= 0x80 ) { val >>= 7; size++; }
+    return size;
+}
+
+/// @brief write value as varint ( LEB128 ), for internal use
+/// @return pointer past the written varint
+unsigned char * dtype__varint_write(unsigned char * dst, uint64_t val)
+{
+    while ( val >= 0x80 ) {
+        *dst++ = (unsigned char)(val | 0x80);
+        val >>= 7;
+    }
+    *dst++ = (unsigned char)val;
+    return dst;
+}
+
+/// @brief read varint ( LEB128 ), for internal use
+/// @return false if varint is truncated or too long
+bool dtype__varint_read(const unsigned char ** src, const unsigned char * end, uint64_t * val)
+{
+    *val = 0;
+    for ( unsigned shift = 0; shift < 64 && *src < end; shift += 7 ) {
+        unsigned char byte = *(*src)++;
+        *val |= (uint64_t)(byte & 0x7f) << shift;
+        if ( !(byte & 0x80) ) { return true; }
+    }
+    return false;
+}
+
+/// @brief FNV-1a hash of a string, for internal use
+uint64_t dtype__hash_str(const char * str, size_t len)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for ( size_t i = 0; i < len; i++ ) { hash = (hash ^ (unsigned char)str[i]) * 0x100000001b3ULL; }
+    return hash;
+}
+
+/// @brief encode string values with DTYPE_CODEC_DICT_RLE [ DTYPE_NONE values are kept as null ]
+/// @param vals the values to encode, each must be a string or none
+/// @param count number of values
+/// @param out the dtype variable to store the encoded bytes in
+/// @return the dtype variable ( DTYPE_CUSTOM ) with the encoded block, or cleared variable on error
+dtype dtype_strings_encode(const dtype * vals, size_t count, dtype out)
+{
+    for ( size_t i = 0; i < count; i++ ) {
+        if ( vals[i].type != DTYPE_STRING && vals[i].type != DTYPE_NONE ) {
+            if ( dtype__raise("dtype_strings_encode", "Type mismatch while encoding", DTYPE_TYPE_ERROR) ) {
+                fprintf(stderr, ": `%s` at index %lu\n", dtype_get_str_type(vals[i]), i);
+            }
+            return dtype_clear(out);
+        }
+    }
+    size_t slots = 16;
+    while ( slots < count * 2 ) { slots *= 2; }
+    // ids : 0 is null, n is the n-th distinct string ; table maps hash slots to ids
+    size_t * ids = malloc(count * sizeof(size_t) + 1);
+    size_t * table = calloc(slots, sizeof(size_t));
+    size_t * dict = malloc(count * sizeof(size_t) + 1);
+    if ( ids == NULL || table == NULL || dict == NULL ) {
+        dtype__mem_error(slots * sizeof(size_t), "dtype_strings_encode");
+        free(ids); free(table); free(dict);
+        return dtype_clear(out);
+    }
+    size_t distinct = 0;
+    size_t bytes = 0;
+    for ( size_t i = 0; i < count; i++ ) {
+        if ( vals[i].type == DTYPE_NONE ) { ids[i] = 0; continue; }
+        const char * str = vals[i].mem;
+        size_t len = strlen(str);
+        size_t slot = (size_t)dtype__hash_str(str, len) & (slots - 1);
+        while ( table[slot] ) {
+            const char * other = vals[dict[table[slot] - 1]].mem;
+            if ( strcmp(other, str) == 0 ) { break; }
+            slot = (slot + 1) & (slots - 1);
+        }
+        if ( !table[slot] ) {
+            dict[distinct++] = i;
+            table[slot] = distinct;
+            bytes += dtype__varint_size(len) + len;
+        }
+        ids[i] = table[slot];
+    }
+    free(table);
+    // size the runs before writing so output is allocated once
+    size_t runs = 0;
+    for ( size_t i = 0; i < count; ) {
+        size_t j = i + 1;
+        while ( j < count && ids[j] == ids[i] ) { j++; }
+        bytes += dtype__varint_size(ids[i]) + dtype__varint_size(j - i);
+        runs++;
+        i = j;
+    }
+    bytes += DTYPE__BLOCK_HEADER + dtype__varint_size(distinct) + dtype__varint_size(runs);
+    out = dtype__mem_refresh(out, bytes, "dtype_strings_encode");
+    if ( out.size ) {
+        unsigned char * p = dtype__write_header(out.mem, DTYPE_CODEC_DICT_RLE, DTYPE_STRING, false, count);
+        p = dtype__varint_write(p, distinct);
+        for ( size_t k = 0; k < distinct; k++ ) {
+            const char * str = vals[dict[k]].mem;
+            size_t len = strlen(str);
+            p = dtype__varint_write(p, len);
+            memcpy(p, str, len);
+            p += len;
+        }
+        p = dtype__varint_write(p, runs);
+        for ( size_t i = 0; i < count; ) {
+            size_t j = i + 1;
+            while ( j < count && ids[j] == ids[i] ) { j++; }
+            p = dtype__varint_write(dtype__varint_write(p, ids[i]), j - i);
+            i = j;
+        }
+        out.type = DTYPE_CUSTOM;
+    }
+    free(ids);
+    free(dict);
+    return out;
+}
+
+/// @brief decode a block created by dtype_strings_encode
+/// @param mem pointer to the encoded block
+/// @param size size of the encoded block
+/// @param count set to the number of decoded values
+/// @return malloc'd array of values [ clear each & free the array ], or NULL on error
+dtype * dtype_strings_decode(const void * mem, size_t size, size_t * count)
+{
+    const unsigned char * p = mem;
+    const unsigned char * end = p + size;
+    *count = 0;
+    uint64_t length = 0, distinct = 0, runs = 0;
+    if ( size < DTYPE__BLOCK_HEADER || p[0] != DTYPE_CODEC_DICT_RLE || p[1] != DTYPE_STRING ) {
+        dtype__format_error("dtype_strings_decode");
+        return NULL;
+    }
+    memcpy(&length, p + 8, 8);
+    p += DTYPE__BLOCK_HEADER;
+    if ( !dtype__varint_read(&p, end, &distinct) || distinct > (size_t)(end - p) ) {
+        dtype__format_error("dtype_strings_decode");
+        return NULL;
+    }
+    // dictionary entries point into the block, strings are copied out when expanding runs
+    const unsigned char ** strs = malloc(distinct * sizeof(char *) + 1);
+    size_t * lens = malloc(distinct * sizeof(size_t) + 1);
+    dtype * vals = NULL;
+    bool ok = strs != NULL && lens != NULL;
+    for ( size_t k = 0; ok && k < distinct; k++ ) {
+        uint64_t len;
+        ok = dtype__varint_read(&p, end, &len) && len <= (uint64_t)(end - p);
+        if ( ok ) {
+            strs[k] = p;
+            lens[k] = len;
+            p += len;
+        }
+    }
+    ok = ok && dtype__varint_read(&p, end, &runs);
+    if ( ok ) {
+        vals = calloc(length ? length : 1, sizeof(dtype));
+        if ( vals == NULL ) { dtype__mem_error(length * sizeof(dtype), "dtype_strings_decode"); }
+    }
+    size_t at = 0;
+    for ( uint64_t r = 0; vals != NULL && ok && r < runs; r++ ) {
+        uint64_t id, run;
+        ok = dtype__varint_read(&p, end, &id) && dtype__varint_read(&p, end, &run)
+            && id <= distinct && run <= length - at;
+        for ( uint64_t i = 0; ok && id && i < run; i++ ) {
+            vals[at + i] = dtype__mem_refresh(vals[at + i], lens[id - 1] + 1, "dtype_strings_decode");
+            ok = vals[at + i].size != 0;
+            if ( ok ) {
+                memcpy(vals[at + i].mem, strs[id - 1], lens[id - 1]);
+                ((char *)vals[at + i].mem)[lens[id - 1]] = '\0';
+                vals[at + i].type = DTYPE_STRING;
+            }
+        }
+        at += ok ? run : 0;
+    }
+    free(strs);
+    free(lens);
+    if ( vals == NULL || !ok || at != length ) {
+        for ( size_t i = 0; vals != NULL && i < length; i++ ) { dtype_clear(vals[i]); }
+        free(vals);
+        // a failed allocation of values is already reported as memory error
+        if ( !ok || vals != NULL ) { dtype__format_error("dtype_strings_decode"); }
+        return NULL;
+    }
+    *count = length;
+    return vals;
+}
+
+// ----------------- Arithmetic Functions ----------------
+
+/// @brief number of elements computed at once, small enough for the buffers to stay in cache
+#define DTYPE__CHUNK 256
+
+/// @brief check if type is a floating point type, for internal use
+bool dtype__type_is_float(enum DTYPE_TYPES type)
+{
+    return type == DTYPE_FLOAT || type == DTYPE_DOUBLE || type == DTYPE_FLOAT16 || type == DTYPE_BFLOAT16;
+}
+
+/// @brief fixed width integer type of given size & signedness, for internal use
+enum DTYPE_TYPES dtype__int_type(size_t size, bool sign)
+{
+    switch ( size )
+    {
+        case 1: return sign ? DTYPE_INT8 : DTYPE_UINT8;
+        case 2: return sign ? DTYPE_INT16 : DTYPE_UINT16;
+        case 4: return sign ? DTYPE_INT32 : DTYPE_UINT32;
+        default: return sign ? DTYPE_INT64 : DTYPE_UINT64;
+    }
+}
+
+/// @brief type the elements of given result type are computed in, for internal use
+/// @return DTYPE_INT64, DTYPE_UINT64, DTYPE_FLOAT or DTYPE_DOUBLE
+enum DTYPE_TYPES dtype__compute_type(enum DTYPE_TYPES type)
+{
+    if ( type == DTYPE_DOUBLE ) { return DTYPE_DOUBLE; }
+    if ( dtype__type_is_float(type) ) { return DTYPE_FLOAT; }
+    return dtype__type_is_signed(type) ? DTYPE_INT64 : DTYPE_UINT64;
+}
+
+/// @brief load `count` elements from `start` converted to compute type, for internal use
+/// [ length 1 arrays are broadcast ]
+void dtype__load_chunk(void * buf, enum DTYPE_TYPES ctype, dtype_array arr, size_t start, size_t count)
+{
+    if ( arr.length == 1 && start + count > 1 ) {
+        dtype__load_chunk(buf, ctype, arr, 0, 1);
+        size_t size = ctype == DTYPE_FLOAT ? sizeof(float) : 8;
+        for ( size_t i = 1; i < count; i++ ) { memcpy((char *)buf + i * size, buf, size); }
+        return;
+    }
+    size_t size = dtype_type_size(arr.type);
+    const char * src = (const char *)arr.mem + start * size;
+    uint64_t tmp[DTYPE__CHUNK];
+    uint64_t * ints = (ctype == DTYPE_INT64 || ctype == DTYPE_UINT64) ? buf : tmp;
+    if ( ctype == DTYPE_FLOAT ) {
+        switch ( arr.type )
+        {
+            case DTYPE_FLOAT: memcpy(buf, src, count * sizeof(float)); return;
+            case DTYPE_FLOAT16: dtype_float16_to_float(buf, (const uint16_t *)src, count); return;
+            case DTYPE_BFLOAT16: dtype_bfloat16_to_float(buf, (const uint16_t *)src, count); return;
+            default: break;
+        }
+    } else if ( ctype == DTYPE_DOUBLE ) {
+        double * dst = buf;
+        float * floats = (float *)tmp;
+        switch ( arr.type )
+        {
+            case DTYPE_DOUBLE: memcpy(buf, src, count * sizeof(double)); return;
+            case DTYPE_FLOAT: memcpy(floats, src, count * sizeof(float)); break;
+            case DTYPE_FLOAT16: dtype_float16_to_float(floats, (const uint16_t *)src, count); break;
+            case DTYPE_BFLOAT16: dtype_bfloat16_to_float(floats, (const uint16_t *)src, count); break;
+            default: floats = NULL; break;
+        }
+        if ( floats != NULL ) {
+            for ( size_t i = 0; i < count; i++ ) { dst[i] = floats[i]; }
+            return;
+        }
+    }
+    // integers & booleans, widened to 64 bits first
+    bool sign = dtype__type_is_signed(arr.type);
+    if ( arr.type == DTYPE_BOOL ) {
+        for ( size_t i = 0; i < count; i++ ) { ints[i] = dtype__bit_get(arr.mem, start + i); }
+    } else {
+        dtype__load_block(ints, arr.mem, start, count, size, sign);
+    }
+    if ( ctype == DTYPE_FLOAT ) {
+        for ( size_t i = 0; i < count; i++ ) { ((float *)buf)[i] = sign ? (float)(int64_t)ints[i] : (float)ints[i]; }
+    } else if ( ctype == DTYPE_DOUBLE ) {
+        for ( size_t i = 0; i < count; i++ ) { ((double *)buf)[i] = sign ? (double)(int64_t)ints[i] : (double)ints[i]; }
+    }
+}
+
+/// @brief store `count` computed elements at `start` converted to the array type, for internal use
+void dtype__store_chunk(dtype_array out, size_t start, const void * buf, size_t count)
+{
+    size_t size = dtype_type_size(out.type);
+    char * dst = (char *)out.mem + start * size;
+    switch ( out.type )
+    {
+        case DTYPE_FLOAT: case DTYPE_DOUBLE: memcpy(dst, buf, count * size); break;
+        case DTYPE_FLOAT16: dtype_float_to_float16((uint16_t *)dst, buf, count); break;
+        case DTYPE_BFLOAT16: dtype_float_to_bfloat16((uint16_t *)dst, buf, count); break;
+        default: dtype__store_block(out.mem, start, buf, count, size); break;
+    }
+}
+
+#if defined(DTYPE_X86_SIMD)
+
+/// @brief AVX2 kernel for double arithmetic, returns number of elements done
+__attribute__((target("avx2")))
+size_t dtype__op_f64_avx2(double * acc, const double * rhs, size_t count, enum DTYPE_OPS op)
+{
+    size_t i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        __m256d a = _mm256_loadu_pd(acc + i), b = _mm256_loadu_pd(rhs + i);
+        switch ( op )
+        {
+            case DTYPE_OP_ADD: a = _mm256_add_pd(a, b); break;
+            case DTYPE_OP_SUB: a = _mm256_sub_pd(a, b); break;
+            case DTYPE_OP_MUL: a = _mm256_mul_pd(a, b); break;
+            case DTYPE_OP_DIV: a = _mm256_div_pd(a, b); break;
+            case DTYPE_OP_MIN: a = _mm256_min_pd(a, b); break;
+            case DTYPE_OP_MAX: a = _mm256_max_pd(a, b); break;
+        }
+        _mm256_storeu_pd(acc + i, a);
+    }
+    return i;
+}
+
+/// @brief AVX2 kernel for float arithmetic, returns number of elements done
+__attribute__((target("avx2")))
+size_t dtype__op_f32_avx2(float * acc, const float * rhs, size_t count, enum DTYPE_OPS op)
+{
+    size_t i = 0;
+    for ( ; i + 8 <= count; i += 8 ) {
+        __m256 a = _mm256_loadu_ps(acc + i), b = _mm256_loadu_ps(rhs + i);
+        switch ( op )
+        {
+            case DTYPE_OP_ADD: a = _mm256_add_ps(a, b); break;
+            case DTYPE_OP_SUB: a = _mm256_sub_ps(a, b); break;
+            case DTYPE_OP_MUL: a = _mm256_mul_ps(a, b); break;
+            case DTYPE_OP_DIV: a = _mm256_div_ps(a, b); break;
+            case DTYPE_OP_MIN: a = _mm256_min_ps(a, b); break;
+            case DTYPE_OP_MAX: a = _mm256_max_ps(a, b); break;
+        }
+        _mm256_storeu_ps(acc + i, a);
+    }
+    return i;
+}
+
+/// @brief AVX2 kernel for 64-bit integer add, sub, min & max, returns number of elements done
+/// [ mul & div have no AVX2 instruction and are left to the scalar loop ]
+__attribute__((target("avx2")))
+size_t dtype__op_i64_avx2(uint64_t * acc, const uint64_t * rhs, size_t count, enum DTYPE_OPS op, bool sign)
+{
+    if ( op == DTYPE_OP_MUL || op == DTYPE_OP_DIV ) { return 0; }
+    // unsigned order is signed order with the sign bit flipped
+    const __m256i flip = _mm256_set1_epi64x(sign ? 0 : (long long)0x8000000000000000ULL);
+    size_t i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(acc + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(rhs + i));
+        __m256i gt = _mm256_cmpgt_epi64(_mm256_xor_si256(a, flip), _mm256_xor_si256(b, flip));
+        switch ( op )
+        {
+            case DTYPE_OP_ADD: a = _mm256_add_epi64(a, b); break;
+            case DTYPE_OP_SUB: a = _mm256_sub_epi64(a, b); break;
+            case DTYPE_OP_MIN: a = _mm256_blendv_epi8(a, b, gt); break;
+            case DTYPE_OP_MAX: a = _mm256_blendv_epi8(b, a, gt); break;
+            default: break;
+        }
+        _mm256_storeu_si256((__m256i *)(acc + i), a);
+    }
+    return i;
+}
+
+/// @brief AVX2 kernel for double comparison into bits, returns number of elements done
+__attribute__((target("avx2")))
+size_t dtype__cmp_f64_avx2(uint64_t * bits, const double * a, const double * b, size_t count, enum DTYPE_CMPS op)
+{
+    size_t i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        __m256d va = _mm256_loadu_pd(a + i), vb = _mm256_loadu_pd(b + i), res;
+        switch ( op )
+        {
+            case DTYPE_CMP_EQ: res = _mm256_cmp_pd(va, vb, _CMP_EQ_OQ); break;
+            case DTYPE_CMP_NE: res = _mm256_cmp_pd(va, vb, _CMP_NEQ_UQ); break;
+            case DTYPE_CMP_LT: res = _mm256_cmp_pd(va, vb, _CMP_LT_OQ); break;
+            case DTYPE_CMP_LE: res = _mm256_cmp_pd(va, vb, _CMP_LE_OQ); break;
+            case DTYPE_CMP_GT: res = _mm256_cmp_pd(va, vb, _CMP_GT_OQ); break;
+            default: res = _mm256_cmp_pd(va, vb, _CMP_GE_OQ); break;
+        }
+        bits[i / 64] |= (uint64_t)_mm256_movemask_pd(res) << (i % 64);
+    }
+    return i;
+}
+
+/// @brief AVX2 kernel for float comparison into bits, returns number of elements done
+__attribute__((target("avx2")))
+size_t dtype__cmp_f32_avx2(uint64_t * bits, const float * a, const float * b, size_t count, enum DTYPE_CMPS op)
+{
+    size_t i = 0;
+    for ( ; i + 8 <= count; i += 8 ) {
+        __m256 va = _mm256_loadu_ps(a + i), vb = _mm256_loadu_ps(b + i), res;
+        switch ( op )
+        {
+            case DTYPE_CMP_EQ: res = _mm256_cmp_ps(va, vb, _CMP_EQ_OQ); break;
+            case DTYPE_CMP_NE: res = _mm256_cmp_ps(va, vb, _CMP_NEQ_UQ); break;
+            case DTYPE_CMP_LT: res = _mm256_cmp_ps(va, vb, _CMP_LT_OQ); break;
+            case DTYPE_CMP_LE: res = _mm256_cmp_ps(va, vb, _CMP_LE_OQ); break;
+            case DTYPE_CMP_GT: res = _mm256_cmp_ps(va, vb, _CMP_GT_OQ); break;
+            default: res = _mm256_cmp_ps(va, vb, _CMP_GE_OQ); break;
+        }
+        bits[i / 64] |= (uint64_t)_mm256_movemask_ps(res) << (i % 64);
+    }
+    return i;
+}
+
+/// @brief AVX2 kernel for 64-bit integer comparison into bits, returns number of elements done
+__attribute__((target("avx2")))
+size_t dtype__cmp_i64_avx2(uint64_t * bits, const uint64_t * a, const uint64_t * b, size_t count, enum DTYPE_CMPS op, bool sign)
+{
+    const __m256i flip = _mm256_set1_epi64x(sign ? 0 : (long long)0x8000000000000000ULL);
+    size_t i = 0;
+    for ( ; i + 4 <= count; i += 4 ) {
+        __m256i va = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(a + i)), flip);
+        __m256i vb = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(b + i)), flip);
+        __m256i res;
+        bool negate = op == DTYPE_CMP_NE || op == DTYPE_CMP_LE || op == DTYPE_CMP_GE;
+        switch ( op )
+        {
+            case DTYPE_CMP_EQ: case DTYPE_CMP_NE: res = _mm256_cmpeq_epi64(va, vb); break;
+            case DTYPE_CMP_GT: case DTYPE_CMP_LE: res = _mm256_cmpgt_epi64(va, vb); break;
+            default: res = _mm256_cmpgt_epi64(vb, va); break;
+        }
+        uint64_t mask = (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(res));
+        bits[i / 64] |= (negate ? ~mask & 0xf : mask) << (i % 64);
+    }
+    return i;
+}
+
+#endif // DTYPE_X86_SIMD
+
+/// @brief apply `acc = acc op rhs` on computed elements, for internal use
+/// [ bits of `zero` are set where an integer division by zero happened ]
+/// @return true if any integer division by zero happened
+bool dtype__apply_op(void * acc, const void * rhs, size_t count, enum DTYPE_OPS op, enum DTYPE_TYPES ctype, uint64_t * zero)
+{
+    size_t i = 0;
+    if ( ctype == DTYPE_DOUBLE ) {
+        double * a = acc;
+        const double * b = rhs;
+#if defined(DTYPE_X86_SIMD)
+        if ( dtype__cpu_has_avx2() ) { i = dtype__op_f64_avx2(a, b, count, op); }
+#endif
+        for ( ; i < count; i++ ) {
+            switch ( op )
+            {
+                case DTYPE_OP_ADD: a[i] += b[i]; break;
+                case DTYPE_OP_SUB: a[i] -= b[i]; break;
+                case DTYPE_OP_MUL: a[i] *= b[i]; break;
+                case DTYPE_OP_DIV: a[i] /= b[i]; break;
+                case DTYPE_OP_MIN: a[i] = a[i] < b[i] ? a[i] : b[i]; break;
+                case DTYPE_OP_MAX: a[i] = a[i] > b[i] ? a[i] : b[i]; break;
+            }
+        }
+        return false;
+    }
+    if ( ctype == DTYPE_FLOAT ) {
+        float * a = acc;
+        const float * b = rhs;
+#if defined(DTYPE_X86_SIMD)
+        if ( dtype__cpu_has_avx2() ) { i = dtype__op_f32_avx2(a, b, count, op); }
+#endif
+        for ( ; i < count; i++ ) {
+            switch ( op )
+            {
+                case DTYPE_OP_ADD: a[i] += b[i]; break;
+                case DTYPE_OP_SUB: a[i] -= b[i]; break;
+                case DTYPE_OP_MUL: a[i] *= b[i]; break;
+                case DTYPE_OP_DIV: a[i] /= b[i]; break;
+                case DTYPE_OP_MIN: a[i] = a[i] < b[i] ? a[i] : b[i]; break;
+                case DTYPE_OP_MAX: a[i] = a[i] > b[i] ? a[i] : b[i]; break;
+            }
+        }
+        return false;
+    }
+    uint64_t * a = acc;
+    const uint64_t * b = rhs;
+    bool sign = ctype == DTYPE_INT64;
+    bool zeros = false;
+#if defined(DTYPE_X86_SIMD)
+    if ( dtype__cpu_has_avx2() ) { i = dtype__op_i64_avx2(a, b, count, op, sign); }
+#endif
+    for ( ; i < count; i++ ) {
+        bool less = sign ? (int64_t)a[i] < (int64_t)b[i] : a[i] < b[i];
+        switch ( op )
+        {
+            case DTYPE_OP_ADD: a[i] += b[i]; break;
+            case DTYPE_OP_SUB: a[i] -= b[i]; break;
+            case DTYPE_OP_MUL: a[i] *= b[i]; break;
+            case DTYPE_OP_MIN: a[i] = less ? a[i] : b[i]; break;
+            case DTYPE_OP_MAX: a[i] = less ? b[i] : a[i]; break;
+            case DTYPE_OP_DIV:
+                if ( b[i] == 0 ) {
+                    zero[i / 64] |= (uint64_t)1 << (i % 64);
+                    zeros = true;
+                    a[i] = 0;
+                } else if ( sign ) {
+                    // INT64_MIN / -1 overflows, negating wraps around instead
+                    a[i] = (int64_t)b[i] == -1 ? ~a[i] + 1 : (uint64_t)((int64_t)a[i] / (int64_t)b[i]);
+                } else {
+                    a[i] /= b[i];
+                }
+                break;
+        }
+    }
+    return zeros;
+}
+
+/// @brief compare computed elements into bits ( bits must be zeroed ), for internal use
+void dtype__apply_cmp(uint64_t * bits, const void * lhs, const void * rhs, size_t count, enum DTYPE_CMPS op, enum DTYPE_TYPES ctype)
+{
+    size_t i = 0;
+    if ( ctype == DTYPE_DOUBLE ) {
+        const double * a = lhs, * b = rhs;
+#if defined(DTYPE_X86_SIMD)
+        if ( dtype__cpu_has_avx2() ) { i = dtype__cmp_f64_avx2(bits, a, b, count, op); }
+#endif
+        for ( ; i < count; i++ ) {
+            bool res;
+            switch ( op )
+            {
+                case DTYPE_CMP_EQ: res = a[i] == b[i]; break;
+                case DTYPE_CMP_NE: res = a[i] != b[i]; break;
+                case DTYPE_CMP_LT: res = a[i] < b[i]; break;
+                case DTYPE_CMP_LE: res = a[i] <= b[i]; break;
+                case DTYPE_CMP_GT: res = a[i] > b[i]; break;
+                default: res = a[i] >= b[i]; break;
+            }
+            bits[i / 64] |= (uint64_t)res << (i % 64);
+        }
+        return;
+    }
+    if ( ctype == DTYPE_FLOAT ) {
+        const float * a = lhs, * b = rhs;
+#if defined(DTYPE_X86_SIMD)
+        if ( dtype__cpu_has_avx2() ) { i = dtype__cmp_f32_avx2(bits, a, b, count, op); }
+#endif
+        for ( ; i < count; i++ ) {
+            bool res;
+            switch ( op )
+            {
+                case DTYPE_CMP_EQ: res = a[i] == b[i]; break;
+                case DTYPE_CMP_NE: res = a[i] != b[i]; break;
+                case DTYPE_CMP_LT: res = a[i] < b[i]; break;
+                case DTYPE_CMP_LE: res = a[i] <= b[i]; break;
+                case DTYPE_CMP_GT: res = a[i] > b[i]; break;
+                default: res = a[i] >= b[i]; break;
+            }
+            bits[i / 64] |= (uint64_t)res << (i % 64);
+        }
+        return;
+    }
+    const uint64_t * a = lhs, * b = rhs;
+    bool sign = ctype == DTYPE_INT64;
+#if defined(DTYPE_X86_SIMD)
+    if ( dtype__cpu_has_avx2() ) { i = dtype__cmp_i64_avx2(bits, a, b, count, op, sign); }
+#endif
+    for ( ; i < count; i++ ) {
+        bool less = sign ? (int64_t)a[i] < (int64_t)b[i] : a[i] < b[i];
+        bool res;
+        switch ( op )
+        {
+            case DTYPE_CMP_EQ: res = a[i] == b[i]; break;
+            case DTYPE_CMP_NE: res = a[i] != b[i]; break;
+            case DTYPE_CMP_LT: res = less; break;
+            case DTYPE_CMP_LE: res = less || a[i] == b[i]; break;
+            case DTYPE_CMP_GT: res = !less && a[i] != b[i]; break;
+            default: res = !less; break;
+        }
+        bits[i / 64] |= (uint64_t)res << (i % 64);
+    }
+}
+
+/// @brief get the length of result of given operands, for internal use
+/// @return true if lengths don't match [ error is raised ]
+bool dtype__operands_length(const dtype_array * operands, size_t count, size_t * length, const char * func)
+{
+    *length = 1;
+    for ( size_t k = 0; k < count; k++ ) {
+        if ( operands[k].length != 1 ) { *length = operands[k].length; }
+    }
+    for ( size_t k = 0; k < count; k++ ) {
+        if ( operands[k].length != 1 && operands[k].length != *length ) {
+            dtype__raise(func, "Arrays must be of same length or length 1.\n", DTYPE_INDEX_ERROR);
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief validity bitmap of result, null where any operand is null, for internal use
+/// @return malloc'd bitmap, or NULL when every element is valid [ or on memory error ]
+uint64_t * dtype__operands_valid(const dtype_array * operands, size_t count, size_t length, const char * func)
+{
+    size_t words = dtype__bitmap_words(length);
+    uint64_t * valid = NULL;
+    for ( size_t k = 0; k < count && length; k++ ) {
+        if ( operands[k].valid == NULL ) { continue; }
+        if ( valid == NULL ) {
+            valid = malloc(words * sizeof(uint64_t));
+            if ( valid == NULL ) {
+                dtype__mem_error(words * sizeof(uint64_t), func);
+                return NULL;
+            }
+            memset(valid, 0xff, words * sizeof(uint64_t));
+            valid[words - 1] &= dtype__bitmap_tail_mask(length);
+        }
+        if ( operands[k].length == 1 && length != 1 ) {
+            // a null broadcast value makes everything null
+            if ( !dtype__bit_get(operands[k].valid, 0) ) { memset(valid, 0, words * sizeof(uint64_t)); }
+        } else {
+            dtype__bitmap_op(valid, valid, operands[k].valid, words, 0);
+        }
+    }
+    return valid;
+}
+
+/// @brief make `out` an array of given type & length, reusing its memory if it already is, for internal use
+/// [ validity bitmap of out is replaced by `valid`, a replaced out is set to `old` to be cleared once operands are done ]
+dtype_array dtype__array_reuse(dtype_array out, enum DTYPE_TYPES type, size_t length, uint64_t * valid, dtype_array * old)
+{
+    *old = dtype_array_default();
+    if ( out.type == type && out.length == length && (out.mem != NULL || !length) ) {
+        free(out.valid);
+    } else {
+        *old = out;
+        out = dtype_array_new(type, length);
+        if ( length && out.mem == NULL ) {
+            free(valid);
+            return out;
+        }
+    }
+    out.valid = valid;
+    return out;
+}
+
+/// @brief get the type two types are promoted to in arithmetic
+/// @param a type of left operand
+/// @param b type of right operand
+/// @return the promoted type, or DTYPE_NONE if either type is not numeric
+enum DTYPE_TYPES dtype_promote(enum DTYPE_TYPES a, enum DTYPE_TYPES b)
+{
+    bool numeric = (a == DTYPE_BOOL || dtype__type_is_integer(a) || dtype__type_is_float(a))
+        && (b == DTYPE_BOOL || dtype__type_is_integer(b) || dtype__type_is_float(b));
+    if ( !numeric ) { return DTYPE_NONE; }
+    // booleans take part in arithmetic as uint8
+    a = a == DTYPE_BOOL ? DTYPE_UINT8 : a;
+    b = b == DTYPE_BOOL ? DTYPE_UINT8 : b;
+    if ( a == b ) { return a; }
+    bool afloat = dtype__type_is_float(a), bfloat = dtype__type_is_float(b);
+    if ( a == DTYPE_DOUBLE || b == DTYPE_DOUBLE ) { return DTYPE_DOUBLE; }
+    if ( afloat && bfloat ) { return DTYPE_FLOAT; }
+    if ( afloat || bfloat ) {
+        // float can't hold every 32 or 64 bit integer exactly
+        return dtype_type_size(afloat ? b : a) >= 4 ? DTYPE_DOUBLE : DTYPE_FLOAT;
+    }
+    size_t asize = dtype_type_size(a), bsize = dtype_type_size(b);
+    bool asign = dtype__type_is_signed(a), bsign = dtype__type_is_signed(b);
+    if ( asign == bsign ) { return dtype__int_type(asize > bsize ? asize : bsize, asign); }
+    // mixed signedness, signed type must be wider than the unsigned one
+    size_t ssize = asign ? asize : bsize, usize = asign ? bsize : asize;
+    return dtype__int_type(ssize > usize ? ssize : usize * 2, true);
+}
+
+/// @brief create a length 1 array holding the value, to be broadcast as operand
+/// @param val the numeric value
+/// @return the created array, or default array on error
+dtype_array dtype_array_scalar(dtype val)
+{
+    dtype_array arr = dtype_array_new(val.type, 1);
+    return arr.length ? dtype_array_set(arr, 0, val) : arr;
+}
+
+/// @brief evaluate `((first op1 operand1) op2 operand2) ...` in one pass without intermediate arrays
+/// @param first the first operand [ length 1 arrays are broadcast ]
+/// @param steps the operations & operands applied in order
+/// @param count number of steps
+/// @param out array to store result in, reused if it already has result type & length, freed otherwise
+/// @return the result array of type promoted over all operands, null where any operand is null
+dtype_array dtype_binop_chain(dtype_array first, const dtype_expr_step * steps, size_t count, dtype_array out)
+{
+    dtype_array * operands = malloc((count + 1) * sizeof(dtype_array));
+    if ( operands == NULL ) {
+        dtype__mem_error((count + 1) * sizeof(dtype_array), "dtype_binop_chain");
+        return out;
+    }
+    operands[0] = first;
+    enum DTYPE_TYPES type = first.type;
+    for ( size_t k = 0; k < count; k++ ) {
+        operands[k + 1] = steps[k].operand;
+        type = dtype_promote(type, steps[k].operand.type);
+    }
+    type = count ? type : dtype_promote(type, type);
+    size_t length;
+    if ( type == DTYPE_NONE ) {
+        dtype__raise("dtype_binop_chain", "Arithmetic needs numeric arrays.\n", DTYPE_TYPE_ERROR);
+    }
+    if ( type == DTYPE_NONE || dtype__operands_length(operands, count + 1, &length, "dtype_binop_chain") ) {
+        free(operands);
+        return out;
+    }
+    uint64_t * valid = dtype__operands_valid(operands, count + 1, length, "dtype_binop_chain");
+    free(operands);
+    dtype_array old;
+    out = dtype__array_reuse(out, type, length, valid, &old);
+    if ( length && out.mem == NULL ) {
+        dtype_array_clear(old);
+        return out;
+    }
+    enum DTYPE_TYPES ctype = dtype__compute_type(type);
+    // the whole chain runs on one chunk at a time, results stay in these buffers
+    uint64_t acc[DTYPE__CHUNK], rhs[DTYPE__CHUNK], zero[DTYPE__CHUNK / 64];
+    for ( size_t start = 0; start < length; start += DTYPE__CHUNK ) {
+        size_t n = length - start < DTYPE__CHUNK ? length - start : DTYPE__CHUNK;
+        memset(zero, 0, sizeof(zero));
+        bool zeros = false;
+        dtype__load_chunk(acc, ctype, first, start, n);
+        for ( size_t k = 0; k < count; k++ ) {
+            dtype__load_chunk(rhs, ctype, steps[k].operand, start, n);
+            zeros |= dtype__apply_op(acc, rhs, n, steps[k].op, ctype, zero);
+        }
+        dtype__store_chunk(out, start, acc, n);
+        if ( zeros ) {
+            // division by zero leaves the element null
+            out = dtype__array_ensure_valid(out, "dtype_binop_chain");
+            for ( size_t w = 0; out.valid && w < dtype__bitmap_words(n); w++ ) { out.valid[start / 64 + w] &= ~zero[w]; }
+        }
+    }
+    // the replaced out may be one of the operands, it is only freed now
+    dtype_array_clear(old);
+    return out;
+}
+
+/// @brief element-wise arithmetic `out = a op b` [ uses AVX2 when the cpu supports it ]
+/// @param op the operation
+/// @param a left operand [ length 1 arrays are broadcast ]
+/// @param b right operand [ length 1 arrays are broadcast ]
+/// @param out array to store result in, reused if it already has result type & length, freed otherwise [ may be `a` or `b` ]
+/// @return the result array of promoted type, null where any operand is null
+dtype_array dtype_binop(enum DTYPE_OPS op, dtype_array a, dtype_array b, dtype_array out)
+{
+    dtype_expr_step step;
+    step.op = op;
+    step.operand = b;
+    return dtype_binop_chain(a, &step, 1, out);
+}
+
+/// @brief element-wise comparison `out_mask = a cmp b` [ uses AVX2 when the cpu supports it ]
+/// @param op the comparison
+/// @param a left operand [ length 1 arrays are broadcast ]
+/// @param b right operand [ length 1 arrays are broadcast ]
+/// @param out_mask boolean array to store result in, reused if it already has the length, freed otherwise
+/// @return the boolean result array, null where any operand is null
+dtype_array dtype_cmp(enum DTYPE_CMPS op, dtype_array a, dtype_array b, dtype_array out_mask)
+{
+    dtype_array operands[2] = { a, b };
+    enum DTYPE_TYPES type = dtype_promote(a.type, b.type);
+    size_t length;
+    if ( type == DTYPE_NONE ) {
+        dtype__raise("dtype_cmp", "Comparison needs numeric arrays.\n", DTYPE_TYPE_ERROR);
+        return out_mask;
+    }
+    if ( dtype__operands_length(operands, 2, &length, "dtype_cmp") ) { return out_mask; }
+    uint64_t * valid = dtype__operands_valid(operands, 2, length, "dtype_cmp");
+    dtype_array old;
+    out_mask = dtype__array_reuse(out_mask, DTYPE_BOOL, length, valid, &old);
+    if ( length && out_mask.mem == NULL ) {
+        dtype_array_clear(old);
+        return out_mask;
+    }
+    enum DTYPE_TYPES ctype = dtype__compute_type(type);
+    uint64_t lhs[DTYPE__CHUNK], rhs[DTYPE__CHUNK], bits[DTYPE__CHUNK / 64];
+    for ( size_t start = 0; start < length; start += DTYPE__CHUNK ) {
+        size_t n = length - start < DTYPE__CHUNK ? length - start : DTYPE__CHUNK;
+        memset(bits, 0, sizeof(bits));
+        dtype__load_chunk(lhs, ctype, a, start, n);
+        dtype__load_chunk(rhs, ctype, b, start, n);
+        dtype__apply_cmp(bits, lhs, rhs, n, op, ctype);
+        memcpy((uint64_t *)out_mask.mem + start / 64, bits, dtype__bitmap_words(n) * sizeof(uint64_t));
+    }
+    dtype_array_clear(old);
+    return out_mask;
+}
+
+// ----------------- Builder Functions ----------------
+
+/// @brief builder capacity never goes below this, for internal use
+#define DTYPE__BUILDER_MIN 16
+
+/// @brief make room for `extra` more bytes & terminator, growing geometrically, for internal use
+/// @return the builder, with size unchanged on memory error
+dtype dtype__builder_reserve(dtype var, size_t extra, const char * func)
+{
+    size_t need = var.length + extra + 1;
+    if ( need <= var.size ) { return var; }
+    size_t capacity = var.size < DTYPE__BUILDER_MIN ? DTYPE__BUILDER_MIN : var.size;
+    while ( capacity < need ) { capacity *= 2; }
+    void * mem = realloc(var.mem, capacity);
+    if ( mem == NULL ) {
+        dtype__mem_error(capacity, func);
+        return var;
+    }
+    var.mem = mem;
+    var.size = capacity;
+    return var;
+}
+
+/// @brief get variable ready for appending, for internal use
+/// @return the variable in builder mode, or unchanged variable on type error
+dtype dtype__builder_prepare(dtype var, const char * func)
+{
+    if ( var.type == DTYPE_STRING_BUILDER ) { return var; }
+    // a none value holding memory, as left by dtype_change_size, is data & not an empty string
+    if ( var.type == DTYPE_STRING || (var.type == DTYPE_NONE && var.mem == NULL) ) { return dtype_builder(var, 0); }
+    if ( dtype__raise(func, "Can only append to a string or builder", DTYPE_TYPE_ERROR) ) {
+        fprintf(stderr, ", not `%s`\n", dtype_get_str_type(var));
+    }
+    return var;
+}
+
+/// @brief append formatted text to builder, for internal use
+dtype dtype__builder_vappendf(dtype var, const char * func, const char * fmt, va_list args)
+{
+    var = dtype__builder_prepare(var, func);
+    if ( var.type != DTYPE_STRING_BUILDER ) { return var; }
+    va_list again;
+    va_copy(again, args);
+    // try the spare capacity first, most appends fit without growing
+    size_t spare = var.size - var.length;
+    int len = vsnprintf((char *)var.mem + var.length, spare, fmt, args);
+    if ( len >= 0 && (size_t)len >= spare ) {
+        var = dtype__builder_reserve(var, (size_t)len, func);
+        len = var.size > var.length + (size_t)len ? vsnprintf((char *)var.mem + var.length, var.size - var.length, fmt, again) : -1;
+    }
+    va_end(again);
+    if ( len < 0 ) {
+        // keep the content as it was before the failed append
+        var.size ? ((char *)var.mem)[var.length] = '\0' : 0;
+        return var;
+    }
+    var.length += (size_t)len;
+    return var;
+}
+
+/// @brief append formatted text to builder, for internal use
+dtype dtype__builder_appendf(dtype var, const char * func, const char * fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    var = dtype__builder_vappendf(var, func, fmt, args);
+    va_end(args);
+    return var;
+}
+
+/// @brief switch the variable to builder mode with room for at least `capacity` bytes
+/// [ a string is taken over without copying, any other type is replaced by an empty builder ]
+/// @param var the dtype variable to switch
+/// @param capacity number of bytes to reserve for content
+/// @return the dtype variable in builder mode
+dtype dtype_builder(dtype var, size_t capacity)
+{
+    if ( var.type == DTYPE_STRING ) {
+        var.length = strlen(var.mem);
+        var.type = DTYPE_STRING_BUILDER;
+    }
+    if ( var.type != DTYPE_STRING_BUILDER ) {
+        var = dtype__mem_refresh(var, capacity < DTYPE__BUILDER_MIN ? DTYPE__BUILDER_MIN : capacity + 1, "dtype_builder");
+        if ( !var.size ) { return var; }
+        ((char *)var.mem)[0] = '\0';
+        var.type = DTYPE_STRING_BUILDER;
+    }
+    return dtype__builder_reserve(var, capacity > var.length ? capacity - var.length : 0, "dtype_builder");
+}
+
+/// @brief append bytes to builder [ strings & empty none values are switched to builder mode first ]
+/// @param var the dtype variable to append to
+/// @param bytes the bytes to append, may point into the builder itself
+/// @param size number of bytes to append
+/// @return the dtype variable with the bytes appended
+dtype dtype_append_bytes(dtype var, const void * bytes, size_t size)
+{
+    var = dtype__builder_prepare(var, "dtype_append_bytes");
+    if ( var.type != DTYPE_STRING_BUILDER ) { return var; }
+    // bytes from the builder itself move along when it grows
+    const char * mem = var.mem;
+    bool inside = (const char *)bytes >= mem && (const char *)bytes < mem + var.size;
+    size_t offset = inside ? (size_t)((const char *)bytes - mem) : 0;
+    var = dtype__builder_reserve(var, size, "dtype_append_bytes");
+    if ( var.size < var.length + size + 1 ) { return var; }
+    memmove((char *)var.mem + var.length, inside ? (const char *)var.mem + offset : bytes, size);
+    var.length += size;
+    ((char *)var.mem)[var.length] = '\0';
+    return var;
+}
+
+/// @brief append a string to builder [ strings & empty none values are switched to builder mode first ]
+/// @param var the dtype variable to append to
+/// @param str the string to append
+/// @return the dtype variable with the string appended
+dtype dtype_append_str(dtype var, const char * str)
+{
+    return dtype_append_bytes(var, str, strlen(str));
+}
+
+/// @brief append printf style formatted text to builder [ strings & empty none values are switched to builder mode first ]
+/// @param var the dtype variable to append to
+/// @param fmt the printf format
+/// @return the dtype variable with the formatted text appended
+dtype dtype_appendf(dtype var, const char * fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    var = dtype__builder_vappendf(var, "dtype_appendf", fmt, args);
+    va_end(args);
+    return var;
+}
+
+/// @brief append the value formatted as dtype_print does [ strings & empty none values are switched to builder mode first ]
+/// @param var the dtype variable to append to
+/// @param val the value to append
+/// @return the dtype variable with the value appended
+dtype dtype_append_value(dtype var, dtype val)
+{
+    const char * func = "dtype_append_value";
+    switch ( val.type )
+    {
+        case DTYPE_NONE: return dtype_append_bytes(var, "none", 4);
+        case DTYPE_BOOL: return dtype_append_str(var, dtype_get_bool(val) ? "true" : "false");
+        case DTYPE_CHAR: return dtype__builder_appendf(var, func, "%c", dtype_get_char(val));
+        case DTYPE_SHORT: return dtype__builder_appendf(var, func, "%hi", dtype_get_short(val));
+        case DTYPE_USHORT: return dtype__builder_appendf(var, func, "%hu", dtype_get_ushort(val));
+        case DTYPE_INT: return dtype__builder_appendf(var, func, "%d", dtype_get_int(val));
+        case DTYPE_UINT: return dtype__builder_appendf(var, func, "%u", dtype_get_uint(val));
+        case DTYPE_LONG: return dtype__builder_appendf(var, func, "%ld", dtype_get_long(val));
+        case DTYPE_ULONG: return dtype__builder_appendf(var, func, "%lu", dtype_get_ulong(val));
+        case DTYPE_FLOAT: return dtype__builder_appendf(var, func, "%f", dtype_get_float(val));
+        case DTYPE_DOUBLE: return dtype__builder_appendf(var, func, "%lf", dtype_get_double(val));
+        case DTYPE_INT8: return dtype__builder_appendf(var, func, "%" PRId8, dtype_get_int8(val));
+        case DTYPE_UINT8: return dtype__builder_appendf(var, func, "%" PRIu8, dtype_get_uint8(val));
+        case DTYPE_INT16: return dtype__builder_appendf(var, func, "%" PRId16, dtype_get_int16(val));
+        case DTYPE_UINT16: return dtype__builder_appendf(var, func, "%" PRIu16, dtype_get_uint16(val));
+        case DTYPE_INT32: return dtype__builder_appendf(var, func, "%" PRId32, dtype_get_int32(val));
+        case DTYPE_UINT32: return dtype__builder_appendf(var, func, "%" PRIu32, dtype_get_uint32(val));
+        case DTYPE_INT64: return dtype__builder_appendf(var, func, "%" PRId64, dtype_get_int64(val));
+        case DTYPE_UINT64: return dtype__builder_appendf(var, func, "%" PRIu64, dtype_get_uint64(val));
+        case DTYPE_FLOAT16: return dtype__builder_appendf(var, func, "%f", dtype_get_float16(val));
+        case DTYPE_BFLOAT16: return dtype__builder_appendf(var, func, "%f", dtype_get_bfloat16(val));
+        case DTYPE_STRING: return dtype_append_str(var, dtype_get_string(val));
+        case DTYPE_STRING_BUILDER: return dtype_append_bytes(var, val.mem, val.length);
+        case DTYPE_CUSTOM: return dtype_append_str(var, "dtype_custom_variable");
+        default:
+            dtype__raise(func, "Invalid type to append.\n", DTYPE_TYPE_ERROR);
+            return var;
+    }
+}
+
+/// @brief finish the builder, turning it into a string without copying
+/// @param var the builder to finish
+/// @return the dtype variable as DTYPE_STRING
+dtype dtype_builder_finish(dtype var)
+{
+    if ( var.type != DTYPE_STRING_BUILDER ) {
+        if ( dtype__raise("dtype_builder_finish", "Not a builder", DTYPE_TYPE_ERROR) ) {
+            fprintf(stderr, ", got `%s`\n", dtype_get_str_type(var));
+        }
+        return var;
+    }
+    // content is always kept terminated, so it already is a valid string
+    var.length = 0;
+    var.type = DTYPE_STRING;
+    return var;
+}
+
+// ----------------- Record Functions ----------------
+
+/// @brief longest record header : type byte & 64-bit varint
+#define DTYPE__RECORD_HEADER 11
+
+/// @brief get the payload of value as stored in a record, for internal use
+/// @return false if value can't be encoded
+bool dtype__record_payload(dtype val, const void ** payload, size_t * size, enum DTYPE_TYPES * type)
+{
+    *type = val.type;
+    *payload = val.mem;
+    switch ( val.type )
+    {
+        // memory without a type, as left by dtype_change_size, has no known payload
+        case DTYPE_NONE: *size = 0; return val.mem == NULL;
+        case DTYPE_STRING: *size = val.mem ? strlen(val.mem) : 0; return true;
+        case DTYPE_STRING_BUILDER: *size = val.length; *type = DTYPE_STRING; return true;
+        case DTYPE_CUSTOM: *size = val.size; return true;
+        default:
+            *size = dtype_type_size(val.type);
+            return *size && val.size >= *size;
+    }
+}
+
+/// @brief encode the value as a record : type byte, varint payload size & payload
+/// [ builders are encoded as strings ]
+/// @param val the value to encode
+/// @param mem memory to write the record to, written only if the record fits
+/// @param size size of memory
+/// @return the size of the record, 0 if value can't be encoded
+size_t dtype_record_encode(dtype val, void * mem, size_t size)
+{
+    const void * payload;
+    size_t len;
+    enum DTYPE_TYPES type;
+    if ( !dtype__record_payload(val, &payload, &len, &type) ) {
+        if ( dtype__raise("dtype_record_encode", "Value can't be encoded", DTYPE_TYPE_ERROR) ) {
+            fprintf(stderr, ": `%s` of size %lu\n", dtype_get_str_type(val), val.size);
+        }
+        return 0;
+    }
+    size_t need = 1 + dtype__varint_size(len) + len;
+    if ( need <= size ) {
+        unsigned char * p = mem;
+        *p++ = (unsigned char)type;
+        p = dtype__varint_write(p, len);
+        len ? memcpy(p, payload, len) : 0;
+    }
+    return need;
+}
+
+/// @brief decode a record created by dtype_record_encode
+/// @param mem pointer to the record
+/// @param size number of bytes available
+/// @param used set to the size of record, 0 if record is invalid or truncated
+/// @param var the dtype variable to store value in
+/// @return the dtype variable with the decoded value
+dtype dtype_record_decode(const void * mem, size_t size, size_t * used, dtype var)
+{
+    const unsigned char * p = mem;
+    const unsigned char * end = p + size;
+    uint64_t len;
+    *used = 0;
+    if ( size < 2 ) { return var; }
+    enum DTYPE_TYPES type = (enum DTYPE_TYPES)*p++;
+    if ( !dtype__varint_read(&p, end, &len) || len > (uint64_t)(end - p) ) { return var; }
+    size_t fixed = dtype_type_size(type);
+    bool valid = type == DTYPE_NONE ? len == 0
+        : ( type == DTYPE_STRING || type == DTYPE_CUSTOM ) ? true
+        : ( fixed && len == fixed );
+    if ( !valid ) {
+        dtype__format_error("dtype_record_decode");
+        return var;
+    }
+    if ( type == DTYPE_NONE ) {
+        var = dtype_clear(var);
+    } else {
+        // strings get their terminator back
+        var = dtype__mem_refresh(var, type == DTYPE_STRING ? len + 1 : len, "dtype_record_decode");
+        if ( !var.size ) { return var; }
+        len ? memcpy(var.mem, p, len) : 0;
+        type == DTYPE_STRING ? ((char *)var.mem)[len] = '\0' : 0;
+        var.type = type;
+    }
+    *used = (size_t)(p - (const unsigned char *)mem) + len;
+    return var;
+}
+
+// ----------------- Writer Functions ----------------
+
+#if defined(DTYPE_POSIX_IO)
+
+/// @brief most producers a writer can have
+#define DTYPE__WRITER_PRODUCERS 256
+/// @brief most iovecs written at once
+#define DTYPE__WRITER_IOV 64
+/// @brief milliseconds the flush thread sleeps when there is nothing to write
+#define DTYPE__WRITER_INTERVAL_MS 10
+
+/// @brief single producer single consumer byte ring, for internal use
+typedef struct dtype__ring {
+    /// @brief the ring memory
+    unsigned char * mem;
+    /// @brief size of memory, power of 2
+    size_t capacity;
+    /// @brief total bytes written, only the producer stores it
+    _Atomic size_t head;
+    /// @brief total bytes flushed, only the flush thread stores it
+    _Atomic size_t tail;
+    /// @brief ring the producer moved on to after this one was full [ DTYPE_BACKPRESSURE_GROW ]
+    _Atomic(struct dtype__ring *) next;
+} dtype__ring;
+
+struct dtype_producer {
+    /// @brief the writer producing for
+    dtype_writer * writer;
+    /// @brief ring the producer writes to
+    dtype__ring * write_ring;
+    /// @brief ring the flush thread reads from [ earlier than write ring while draining old rings ]
+    dtype__ring * read_ring;
+    /// @brief records put
+    _Atomic uint64_t records;
+    /// @brief records dropped
+    _Atomic uint64_t dropped;
+    /// @brief rings grown
+    _Atomic uint64_t grows;
+    /// @brief bytes put
+    _Atomic uint64_t bytes;
+    /// @brief set while no thread owns the producer, guarded by the writer lock
+    bool released;
+};
+
+struct dtype_writer {
+    /// @brief file descriptor of the file written to
+    int fd;
+    /// @brief backpressure policy of producers
+    enum DTYPE_BACKPRESSURE policy;
+    /// @brief starting ring size of producers
+    size_t buffer_size;
+    /// @brief producers, appended under lock & published through count
+    dtype_producer * producers[DTYPE__WRITER_PRODUCERS];
+    /// @brief number of producers
+    _Atomic size_t count;
+    /// @brief the flush thread
+    pthread_t thread;
+    /// @brief lock for the slow paths : waking, blocking & barriers
+    pthread_mutex_t lock;
+    /// @brief signalled to wake the flush thread
+    pthread_cond_t work;
+    /// @brief broadcast by the flush thread after every flush
+    pthread_cond_t done;
+    /// @brief set while the flush thread is waiting for work
+    _Atomic bool sleeping;
+    /// @brief set to stop the flush thread
+    bool stop;
+    /// @brief flush barrier requested & completed generations
+    uint64_t flush_requested, flush_done;
+    /// @brief bytes written & discarded, flushes & flush durations, updated by the flush thread
+    _Atomic uint64_t bytes_written, bytes_discarded, flushes, flush_ns_last, flush_ns_max, flush_ns_total;
+    /// @brief set by the flush thread once a write or sync failed, later writes are dropped
+    bool failed;
+};
+
+/// @brief monotonic time in nanoseconds, for internal use
+uint64_t dtype__now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/// @brief allocate a ring of at least given capacity, for internal use
+dtype__ring * dtype__ring_new(size_t capacity, const char * func)
+{
+    size_t size = 64;
+    while ( size < capacity ) { size *= 2; }
+    dtype__ring * ring = malloc(sizeof(dtype__ring));
+    unsigned char * mem = malloc(size);
+    if ( ring == NULL || mem == NULL ) {
+        dtype__mem_error(size, func);
+        free(ring);
+        free(mem);
+        return NULL;
+    }
+    ring->mem = mem;
+    ring->capacity = size;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->next, NULL);
+    return ring;
+}
+
+/// @brief copy bytes into ring at position, wrapping around, for internal use
+void dtype__ring_copy(dtype__ring * ring, size_t pos, const void * src, size_t size)
+{
+    size_t at = pos & (ring->capacity - 1);
+    size_t first = ring->capacity - at < size ? ring->capacity - at : size;
+    first ? memcpy(ring->mem + at, src, first) : 0;
+    size - first ? memcpy(ring->mem, (const char *)src + first, size - first) : 0;
+}
+
+/// @brief write every iovec completely, for internal use
+/// @return false on write error
+bool dtype__writev_all(int fd, struct iovec * iov, int count)
+{
+    while ( count ) {
+        ssize_t done = writev(fd, iov, count);
+        if ( done < 0 ) {
+            if ( errno == EINTR ) { continue; }
+            return false;
+        }
+        // skip what was written, partially written iovec is advanced in place
+        while ( count && (size_t)done >= iov->iov_len ) {
+            done -= (ssize_t)iov->iov_len;
+            iov++;
+            count--;
+        }
+        if ( count ) {
+            iov->iov_base = (char *)iov->iov_base + done;
+            iov->iov_len -= (size_t)done;
+        }
+    }
+    return true;
+}
+
+/// @brief write everything queued by producers in large batches, for internal use
+/// @return number of bytes written
+size_t dtype__writer_drain(dtype_writer * w)
+{
+    size_t total = 0;
+    for ( ;; ) {
+        struct iovec iov[DTYPE__WRITER_IOV];
+        dtype__ring * rings[DTYPE__WRITER_IOV / 2];
+        size_t heads[DTYPE__WRITER_IOV / 2];
+        int niov = 0, nrings = 0;
+        size_t bytes = 0;
+        size_t count = atomic_load_explicit(&w->count, memory_order_acquire);
+        for ( size_t i = 0; i < count && nrings < DTYPE__WRITER_IOV / 2; i++ ) {
+            dtype_producer * p = w->producers[i];
+            dtype__ring * r = p->read_ring;
+            size_t head, tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+            for ( ;; ) {
+                // next is read before head, so an empty ring with a next can't get more data
+                dtype__ring * next = atomic_load_explicit(&r->next, memory_order_acquire);
+                head = atomic_load_explicit(&r->head, memory_order_acquire);
+                if ( head != tail || next == NULL ) { break; }
+                free(r->mem);
+                free(r);
+                p->read_ring = r = next;
+                tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+            }
+            if ( head == tail ) { continue; }
+            // the readable span is written straight from the ring, in two parts when it wraps
+            size_t at = tail & (r->capacity - 1);
+            size_t len = head - tail;
+            size_t first = r->capacity - at < len ? r->capacity - at : len;
+            iov[niov].iov_base = r->mem + at;
+            iov[niov++].iov_len = first;
+            if ( len > first ) {
+                iov[niov].iov_base = r->mem;
+                iov[niov++].iov_len = len - first;
+            }
+            rings[nrings] = r;
+            heads[nrings++] = head;
+            bytes += len;
+        }
+        if ( !niov ) { break; }
+        if ( !w->failed && !dtype__writev_all(w->fd, iov, niov) ) {
+            w->failed = true;
+            dtype__raise("dtype_writer", "Write to file failed, further records are discarded.\n", DTYPE_IO_ERROR);
+        }
+        for ( int i = 0; i < nrings; i++ ) {
+            atomic_store_explicit(&rings[i]->tail, heads[i], memory_order_release);
+        }
+        // a batch failing part way is counted as discarded, its written part can't be trusted
+        atomic_fetch_add_explicit(w->failed ? &w->bytes_discarded : &w->bytes_written, bytes, memory_order_relaxed);
+        total += bytes;
+        // let blocked producers see the room made
+        pthread_mutex_lock(&w->lock);
+        pthread_cond_broadcast(&w->done);
+        pthread_mutex_unlock(&w->lock);
+    }
+    return total;
+}
+
+/// @brief the flush thread, for internal use
+void * dtype__writer_main(void * arg)
+{
+    dtype_writer * w = arg;
+    pthread_mutex_lock(&w->lock);
+    for ( ;; ) {
+        bool stop = w->stop;
+        uint64_t requested = w->flush_requested;
+        bool barrier = requested != w->flush_done;
+        pthread_mutex_unlock(&w->lock);
+
+        uint64_t start = dtype__now_ns();
+        size_t written = dtype__writer_drain(w);
+        // only barriers sync, so producers never wait behind the disk otherwise
+        if ( (barrier || stop) && !w->failed ) {
+#if defined(__linux__)
+            w->failed = fdatasync(w->fd) != 0;
+#else
+            w->failed = fsync(w->fd) != 0;
+#endif
+            if ( w->failed ) {
+                dtype__raise("dtype_writer", "Sync of file failed, further records are discarded.\n", DTYPE_IO_ERROR);
+            }
+        }
+        if ( written || barrier ) {
+            uint64_t took = dtype__now_ns() - start;
+            atomic_fetch_add_explicit(&w->flushes, 1, memory_order_relaxed);
+            atomic_store_explicit(&w->flush_ns_last, took, memory_order_relaxed);
+            atomic_fetch_add_explicit(&w->flush_ns_total, took, memory_order_relaxed);
+            if ( took > atomic_load_explicit(&w->flush_ns_max, memory_order_relaxed) ) {
+                atomic_store_explicit(&w->flush_ns_max, took, memory_order_relaxed);
+            }
+        }
+
+        pthread_mutex_lock(&w->lock);
+        w->flush_done = requested;
+        pthread_cond_broadcast(&w->done);
+        if ( stop ) { break; }
+        if ( !written && w->flush_requested == requested && !w->stop ) {
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += DTYPE__WRITER_INTERVAL_MS * 1000000L;
+            until.tv_sec += until.tv_nsec / 1000000000L;
+            until.tv_nsec %= 1000000000L;
+            atomic_store(&w->sleeping, true);
+            pthread_cond_timedwait(&w->work, &w->lock, &until);
+            atomic_store(&w->sleeping, false);
+        }
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+/// @brief open an asynchronous writer appending records to a file from a background flush thread
+/// @param path the file to append to, created if it doesn't exist
+/// @param buffer_size starting size of the buffer of each producer [ rounded up to power of 2 ]
+/// @param policy what producers do when their buffer is full
+/// @return the writer, or NULL on error
+dtype_writer * dtype_writer_open(const char * path, size_t buffer_size, enum DTYPE_BACKPRESSURE policy)
+{
+    dtype_writer * w = calloc(1, sizeof(dtype_writer));
+    if ( w == NULL ) {
+        dtype__mem_error(sizeof(dtype_writer), "dtype_writer_open");
+        return NULL;
+    }
+    w->fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if ( w->fd < 0 ) {
+        if ( dtype__raise("dtype_writer_open", "Couldn't open file", DTYPE_IO_ERROR) ) {
+            fprintf(stderr, ": `%s`\n", path);
+        }
+        free(w);
+        return NULL;
+    }
+    w->policy = policy;
+    w->buffer_size = buffer_size;
+    atomic_init(&w->count, 0);
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->work, NULL);
+    pthread_cond_init(&w->done, NULL);
+    if ( pthread_create(&w->thread, NULL, dtype__writer_main, w) != 0 ) {
+        dtype__raise("dtype_writer_open", "Couldn't start the flush thread.\n", DTYPE_IO_ERROR);
+        pthread_cond_destroy(&w->done);
+        pthread_cond_destroy(&w->work);
+        pthread_mutex_destroy(&w->lock);
+        close(w->fd);
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+/// @brief get a producer buffer for the calling thread [ each producer must only be used by one thread ]
+/// @param writer the writer to produce for
+/// @return the producer, or NULL on error [ lives until released or the writer is closed ]
+dtype_producer * dtype_writer_producer(dtype_writer * writer)
+{
+    // a producer released by an exited thread is taken over along with its buffer
+    pthread_mutex_lock(&writer->lock);
+    size_t used = atomic_load_explicit(&writer->count, memory_order_relaxed);
+    for ( size_t i = 0; i < used; i++ ) {
+        if ( writer->producers[i]->released ) {
+            writer->producers[i]->released = false;
+            pthread_mutex_unlock(&writer->lock);
+            return writer->producers[i];
+        }
+    }
+    pthread_mutex_unlock(&writer->lock);
+    dtype_producer * p = calloc(1, sizeof(dtype_producer));
+    dtype__ring * ring = dtype__ring_new(writer->buffer_size, "dtype_writer_producer");
+    if ( p == NULL || ring == NULL ) {
+        p == NULL ? dtype__mem_error(sizeof(dtype_producer), "dtype_writer_producer") : (void)0;
+        free(p);
+        ring ? free(ring->mem) : (void)0;
+        free(ring);
+        return NULL;
+    }
+    p->writer = writer;
+    p->write_ring = p->read_ring = ring;
+    pthread_mutex_lock(&writer->lock);
+    size_t count = atomic_load_explicit(&writer->count, memory_order_relaxed);
+    if ( count == DTYPE__WRITER_PRODUCERS ) {
+        pthread_mutex_unlock(&writer->lock);
+        dtype__raise("dtype_writer_producer", "Too many producers.\n", DTYPE_INDEX_ERROR);
+        free(ring->mem);
+        free(ring);
+        free(p);
+        return NULL;
+    }
+    writer->producers[count] = p;
+    atomic_store_explicit(&writer->count, count + 1, memory_order_release);
+    pthread_mutex_unlock(&writer->lock);
+    return p;
+}
+
+/// @brief hand the producer back once its thread stops putting, for a later dtype_writer_producer to reuse
+/// [ records already put are still written ]
+/// @param producer the producer of calling thread
+void dtype_writer_release_producer(dtype_producer * producer)
+{
+    dtype_writer * w = producer->writer;
+    pthread_mutex_lock(&w->lock);
+    producer->released = true;
+    pthread_mutex_unlock(&w->lock);
+}
+
+/// @brief wake the flush thread, for internal use
+void dtype__writer_wake(dtype_writer * w)
+{
+    pthread_mutex_lock(&w->lock);
+    pthread_cond_signal(&w->work);
+    pthread_mutex_unlock(&w->lock);
+}
+
+/// @brief queue the value as a record, never waits for file writes [ except for DTYPE_BACKPRESSURE_BLOCK when full ]
+/// @param producer the producer of calling thread
+/// @param val the value to queue
+/// @return true if queued, false if dropped or on error
+bool dtype_writer_put(dtype_producer * producer, dtype val)
+{
+    dtype_writer * w = producer->writer;
+    const void * payload;
+    size_t len;
+    enum DTYPE_TYPES type;
+    unsigned char header[DTYPE__RECORD_HEADER];
+    if ( !dtype__record_payload(val, &payload, &len, &type) ) {
+        dtype_record_encode(val, NULL, 0);
+        return false;
+    }
+    header[0] = (unsigned char)type;
+    size_t hsize = (size_t)(dtype__varint_write(header + 1, len) - header);
+    size_t size = hsize + len;
+
+    dtype__ring * r = producer->write_ring;
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    while ( r->capacity - (head - tail) < size ) {
+        if ( w->policy == DTYPE_BACKPRESSURE_BLOCK && size > r->capacity ) {
+            if ( dtype__raise("dtype_writer_put", "Record larger than the buffer", DTYPE_MEMORY_ERROR) ) {
+                fprintf(stderr, ": %lu > %lu\n", size, r->capacity);
+            }
+        }
+        if ( w->policy == DTYPE_BACKPRESSURE_DROP || (w->policy == DTYPE_BACKPRESSURE_BLOCK && size > r->capacity) ) {
+            atomic_fetch_add_explicit(&producer->dropped, 1, memory_order_relaxed);
+            return false;
+        }
+        if ( w->policy == DTYPE_BACKPRESSURE_GROW ) {
+            // the flush thread moves on to the new ring once this one is drained
+            dtype__ring * next = dtype__ring_new(r->capacity * 2 > size ? r->capacity * 2 : size, "dtype_writer_put");
+            if ( next == NULL ) {
+                atomic_fetch_add_explicit(&producer->dropped, 1, memory_order_relaxed);
+                return false;
+            }
+            atomic_store_explicit(&r->next, next, memory_order_release);
+            producer->write_ring = r = next;
+            head = tail = 0;
+            atomic_fetch_add_explicit(&producer->grows, 1, memory_order_relaxed);
+            break;
+        }
+        // block : wait for the flush thread to make room
+        pthread_mutex_lock(&w->lock);
+        pthread_cond_signal(&w->work);
+        tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+        if ( r->capacity - (head - tail) < size ) { pthread_cond_wait(&w->done, &w->lock); }
+        pthread_mutex_unlock(&w->lock);
+        tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    }
+    dtype__ring_copy(r, head, header, hsize);
+    len ? dtype__ring_copy(r, head + hsize, payload, len) : (void)0;
+    atomic_store_explicit(&r->head, head + size, memory_order_release);
+    atomic_fetch_add_explicit(&producer->records, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&producer->bytes, size, memory_order_relaxed);
+    // past half full the flush thread is woken early instead of at its interval
+    if ( head + size - tail > r->capacity / 2 && atomic_load_explicit(&w->sleeping, memory_order_relaxed) ) {
+        dtype__writer_wake(w);
+    }
+    return true;
+}
+
+/// @brief wait until every record queued before the call is written & synced to file
+/// @param writer the writer to flush
+/// @return true if every record so far reached the file, false once a write or sync failed
+bool dtype_writer_flush(dtype_writer * writer)
+{
+    pthread_mutex_lock(&writer->lock);
+    uint64_t generation = ++writer->flush_requested;
+    pthread_cond_signal(&writer->work);
+    while ( writer->flush_done < generation ) { pthread_cond_wait(&writer->done, &writer->lock); }
+    // set before flush_done under the lock, so it is current here
+    bool ok = !writer->failed;
+    pthread_mutex_unlock(&writer->lock);
+    return ok;
+}
+
+/// @brief flush, stop the flush thread & free the writer [ producers must have stopped putting ]
+/// @param writer the writer to close
+/// @return true if every record reached the file, false once a write or sync failed
+bool dtype_writer_close(dtype_writer * writer)
+{
+    pthread_mutex_lock(&writer->lock);
+    writer->stop = true;
+    pthread_cond_signal(&writer->work);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+    size_t count = atomic_load(&writer->count);
+    for ( size_t i = 0; i < count; i++ ) {
+        dtype__ring * r = writer->producers[i]->read_ring;
+        while ( r != NULL ) {
+            dtype__ring * next = atomic_load(&r->next);
+            free(r->mem);
+            free(r);
+            r = next;
+        }
+        free(writer->producers[i]);
+    }
+    // some file systems only report write errors on close
+    bool ok = close(writer->fd) == 0 && !writer->failed;
+    pthread_cond_destroy(&writer->done);
+    pthread_cond_destroy(&writer->work);
+    pthread_mutex_destroy(&writer->lock);
+    free(writer);
+    return ok;
+}
+
+/// @brief get the metrics of writer
+/// @param writer the writer to get metrics of
+/// @return the current metrics
+dtype_writer_stats dtype_writer_get_stats(dtype_writer * writer)
+{
+    dtype_writer_stats stats;
+    memset(&stats, 0, sizeof(stats));
+    uint64_t bytes = 0;
+    size_t count = atomic_load_explicit(&writer->count, memory_order_acquire);
+    for ( size_t i = 0; i < count; i++ ) {
+        dtype_producer * p = writer->producers[i];
+        stats.records += atomic_load_explicit(&p->records, memory_order_relaxed);
+        stats.dropped += atomic_load_explicit(&p->dropped, memory_order_relaxed);
+        stats.grows += atomic_load_explicit(&p->grows, memory_order_relaxed);
+        bytes += atomic_load_explicit(&p->bytes, memory_order_relaxed);
+    }
+    stats.bytes_written = atomic_load_explicit(&writer->bytes_written, memory_order_relaxed);
+    stats.bytes_discarded = atomic_load_explicit(&writer->bytes_discarded, memory_order_relaxed);
+    uint64_t done = stats.bytes_written + stats.bytes_discarded;
+    stats.queue_depth = bytes > done ? (size_t)(bytes - done) : 0;
+    stats.flushes = atomic_load_explicit(&writer->flushes, memory_order_relaxed);
+    stats.flush_ns_last = atomic_load_explicit(&writer->flush_ns_last, memory_order_relaxed);
+    stats.flush_ns_max = atomic_load_explicit(&writer->flush_ns_max, memory_order_relaxed);
+    stats.flush_ns_total = atomic_load_explicit(&writer->flush_ns_total, memory_order_relaxed);
+    return stats;
+}
+
+// ----------------- Store Functions ----------------
+
+/// @brief size of base file header : magic, checkpoint sequence, slot count & reserved
+#define DTYPE__STORE_BASE_HEADER 32
+/// @brief size of log frame header : magic, reserved, sequence, entry count, payload size & checksum
+#define DTYPE__STORE_FRAME_HEADER 40
+/// @brief bytes buffered before writing while compacting
+#define DTYPE__STORE_WRITE_CHUNK (1 << 20)
+
+struct dtype_store {
+    /// @brief file name prefix of the store
+    char * path;
+    /// @brief the values
+    dtype * slots;
+    /// @brief number of slots
+    size_t count;
+    /// @brief dirty bitmap, 1 bit per slot
+    uint64_t * dirty;
+    /// @brief file descriptor of the log, opened for appending
+    int log_fd;
+    /// @brief sequence of the last checkpoint written
+    uint64_t seq;
+    /// @brief size of base & log files, compaction happens when the log outgrows the base
+    size_t base_bytes, log_bytes;
+    /// @brief set when the log may end in a torn frame, the next checkpoint compacts instead of appending
+    bool compact;
+};
+
+/// @brief copy a value, strings & builders as strings, for internal use
+/// @return false on memory or type error
+bool dtype__store_copy(dtype * dst, dtype src, const char * func)
+{
+    const void * payload;
+    size_t len;
+    enum DTYPE_TYPES type;
+    if ( !dtype__record_payload(src, &payload, &len, &type) ) {
+        if ( dtype__raise(func, "Value can't be stored", DTYPE_TYPE_ERROR) ) {
+            fprintf(stderr, ": `%s` of size %lu\n", dtype_get_str_type(src), src.size);
+        }
+        return false;
+    }
+    if ( type == DTYPE_NONE ) {
+        *dst = dtype_clear(*dst);
+        return true;
+    }
+    // a value is often replaced by one of the same size, keep its memory then
+    size_t size = type == DTYPE_STRING ? len + 1 : len;
+    if ( dst->size != size || dst->mem == NULL ) {
+        *dst = dtype__mem_refresh(*dst, size, func);
+        if ( !dst->size && size ) { return false; }
+    }
+    len ? memmove(dst->mem, payload, len) : 0;
+    type == DTYPE_STRING ? ((char *)dst->mem)[len] = '\0' : 0;
+    dst->type = type;
+    return true;
+}
+
+/// @brief grow store to at least given number of slots, for internal use
+/// @return false on memory error
+bool dtype__store_grow(dtype_store * s, size_t count, const char * func)
+{
+    if ( count <= s->count ) { return true; }
+    size_t words = dtype__bitmap_words(count), old = dtype__bitmap_words(s->count);
+    dtype * slots = realloc(s->slots, count * sizeof(dtype));
+    if ( slots == NULL ) {
+        dtype__mem_error(count * sizeof(dtype), func);
+        return false;
+    }
+    s->slots = slots;
+    uint64_t * dirty = realloc(s->dirty, words * sizeof(uint64_t));
+    if ( dirty == NULL ) {
+        dtype__mem_error(words * sizeof(uint64_t), func);
+        return false;
+    }
+    s->dirty = dirty;
+    for ( size_t i = s->count; i < count; i++ ) { s->slots[i] = dtype_default(); }
+    memset(s->dirty + old, 0, (words - old) * sizeof(uint64_t));
+    s->count = count;
+    return true;
+}
+
+/// @brief build a file name from store prefix, for internal use
+char * dtype__store_file(const char * path, const char * suffix)
+{
+    size_t size = strlen(path) + strlen(suffix) + 1;
+    char * name = malloc(size);
+    if ( name == NULL ) {
+        dtype__mem_error(size, "dtype_store");
+        return NULL;
+    }
+    snprintf(name, size, "%s%s", path, suffix);
+    return name;
+}
+
+/// @brief map a whole file read only, for internal use
+/// @return the mapping, or NULL if file is empty or can't be mapped [ size set to file size ]
+const unsigned char * dtype__map_file(int fd, size_t * size)
+{
+    struct stat st;
+    *size = fstat(fd, &st) == 0 ? (size_t)st.st_size : 0;
+    if ( !*size ) { return NULL; }
+    void * map = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    return map == MAP_FAILED ? NULL : map;
+}
+
+/// @brief load the base file into store, for internal use
+/// @return false if base exists but is invalid
+bool dtype__store_load_base(dtype_store * s)
+{
+    char * name = dtype__store_file(s->path, ".base");
+    int fd = name ? open(name, O_RDONLY | O_CLOEXEC) : -1;
+    free(name);
+    if ( fd < 0 ) { return true; }
+    size_t size;
+    const unsigned char * map = dtype__map_file(fd, &size);
+    close(fd);
+    if ( map == NULL ) { return size == 0; }
+    bool ok = size >= DTYPE__STORE_BASE_HEADER && memcmp(map, "DTSTORE", 8) == 0;
+    uint64_t count = 0;
+    if ( ok ) {
+        memcpy(&s->seq, map + 8, 8);
+        memcpy(&count, map + 16, 8);
+        // every slot takes at least 2 bytes, reject counts the file can't hold
+        ok = count <= size / 2 && dtype__store_grow(s, count, "dtype_store_open");
+    }
+    size_t at = DTYPE__STORE_BASE_HEADER;
+    for ( uint64_t i = 0; ok && i < count; i++ ) {
+        size_t used;
+        s->slots[i] = dtype_record_decode(map + at, size - at, &used, s->slots[i]);
+        ok = used != 0;
+        at += used;
+    }
+    munmap((void *)map, size);
+    s->base_bytes = size;
+    if ( !ok ) { dtype__format_error("dtype_store_open"); }
+    return ok;
+}
+
+/// @brief replay log frames newer than the base, dropping a torn frame at the end, for internal use
+/// @return false on memory, format or io error [ the log is then left as is ]
+bool dtype__store_replay_log(dtype_store * s)
+{
+    size_t size;
+    const unsigned char * map = dtype__map_file(s->log_fd, &size);
+    if ( map == NULL ) {
+        s->log_bytes = 0;
+        return true;
+    }
+    size_t at = 0;
+    bool applied = false, ok = true;
+    while ( ok && size - at >= DTYPE__STORE_FRAME_HEADER && memcmp(map + at, "DTLG", 4) == 0 ) {
+        uint64_t seq, entries, payload, sum;
+        memcpy(&seq, map + at + 8, 8);
+        memcpy(&entries, map + at + 16, 8);
+        memcpy(&payload, map + at + 24, 8);
+        memcpy(&sum, map + at + 32, 8);
+        const unsigned char * p = map + at + DTYPE__STORE_FRAME_HEADER;
+        // frame cut short by a crash, or not fully synced
+        if ( payload > size - at - DTYPE__STORE_FRAME_HEADER || dtype__hash_str((const char *)p, payload) != sum ) { break; }
+        const unsigned char * end = p + payload;
+        // frames up to the base sequence are already part of the base
+        for ( uint64_t i = 0; seq > s->seq && ok && i < entries; i++ ) {
+            uint64_t slot;
+            size_t used = 0;
+            // no store has a slot past what an array of them can index
+            if ( !dtype__varint_read(&p, end, &slot) || slot >= SIZE_MAX / sizeof(dtype) ) {
+                dtype__format_error("dtype_store_open");
+            } else if ( dtype__store_grow(s, (size_t)slot + 1, "dtype_store_open") ) {
+                s->slots[slot] = dtype_record_decode(p, (size_t)(end - p), &used, s->slots[slot]);
+                if ( !used ) { dtype__format_error("dtype_store_open"); }
+            }
+            ok = used != 0;
+            p += used;
+        }
+        if ( !ok ) { break; }
+        applied |= seq > s->seq;
+        s->seq = seq > s->seq ? seq : s->seq;
+        at += DTYPE__STORE_FRAME_HEADER + payload;
+    }
+    munmap((void *)map, size);
+    // a complete frame that can't be applied is not a torn tail, keep it for inspection
+    if ( !ok ) { return false; }
+    // a log holding only stale frames is left over from a compaction, start it over
+    at = applied ? at : 0;
+    if ( at != size && ftruncate(s->log_fd, (off_t)at) != 0 ) {
+        dtype__raise("dtype_store_open", "Couldn't truncate the log.\n", DTYPE_IO_ERROR);
+        ok = false;
+    }
+    s->log_bytes = at;
+    return ok;
+}
+
+/// @brief write all bytes, for internal use
+/// @return false on write error
+bool dtype__write_all(int fd, const void * mem, size_t size)
+{
+    struct iovec iov;
+    iov.iov_base = (void *)mem;
+    iov.iov_len = size;
+    return dtype__writev_all(fd, &iov, 1);
+}
+
+/// @brief sync the directory holding the file so a rename in it is durable, for internal use
+void dtype__sync_dir(const char * path)
+{
+    char * dir = dtype__store_file(path, "");
+    if ( dir == NULL ) { return; }
+    char * slash = strrchr(dir, '/');
+    if ( slash != NULL ) { slash[slash == dir] = '\0'; }
+    int fd = open(slash ? dir : ".", O_RDONLY | O_CLOEXEC);
+    if ( fd >= 0 ) {
+        fsync(fd);
+        close(fd);
+    }
+    free(dir);
+}
+
+/// @brief open a store of values, recovering it from `path`.base & replaying `path`.log if they exist
+/// @param path prefix of the store files
+/// @param slots number of slots, grown further if the recovered store has more
+/// @return the store, or NULL on error
+dtype_store * dtype_store_open(const char * path, size_t slots)
+{
+    dtype_store * s = calloc(1, sizeof(dtype_store));
+    if ( s == NULL ) {
+        dtype__mem_error(sizeof(dtype_store), "dtype_store_open");
+        return NULL;
+    }
+    s->log_fd = -1;
+    s->path = dtype__store_file(path, "");
+    char * log = dtype__store_file(path, ".log");
+    s->log_fd = log ? open(log, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644) : -1;
+    if ( s->log_fd < 0 && log != NULL ) {
+        if ( dtype__raise("dtype_store_open", "Couldn't open log", DTYPE_IO_ERROR) ) {
+            fprintf(stderr, ": `%s`\n", log);
+        }
+    }
+    free(log);
+    if ( s->path == NULL || s->log_fd < 0 || !dtype__store_grow(s, slots ? slots : 1, "dtype_store_open")
+        || !dtype__store_load_base(s) || !dtype__store_replay_log(s) ) {
+        dtype_store_close(s);
+        return NULL;
+    }
+    return s;
+}
+
+/// @brief get the number of slots in store
+/// @param store the store
+/// @return number of slots
+size_t dtype_store_slots(dtype_store * store)
+{
+    return store->count;
+}
+
+/// @brief set the value of slot & mark it dirty for the next checkpoint
+/// @param store the store to set in
+/// @param slot index of slot
+/// @param val the value to copy into slot [ builders are stored as strings ]
+/// @return true if set
+bool dtype_store_set(dtype_store * store, size_t slot, dtype val)
+{
+    if ( slot >= store->count ) {
+        if ( dtype__raise("dtype_store_set", "Index out of range", DTYPE_INDEX_ERROR) ) {
+            fprintf(stderr, ": %lu >= slots %lu\n", slot, store->count);
+        }
+        return false;
+    }
+    if ( !dtype__store_copy(&store->slots[slot], val, "dtype_store_set") ) { return false; }
+    dtype__bit_set(store->dirty, slot, true);
+    return true;
+}
+
+/// @brief get the value of slot
+/// @param store the store to get from
+/// @param slot index of slot
+/// @param var the dtype variable to copy value into
+/// @return the dtype variable with value of slot
+dtype dtype_store_get(dtype_store * store, size_t slot, dtype var)
+{
+    if ( slot >= store->count ) {
+        if ( dtype__raise("dtype_store_get", "Index out of range", DTYPE_INDEX_ERROR) ) {
+            fprintf(stderr, ": %lu >= slots %lu\n", slot, store->count);
+        }
+        return var;
+    }
+    dtype__store_copy(&var, store->slots[slot], "dtype_store_get");
+    return var;
+}
+
+/// @brief persist the dirty slots as a delta, or compact when the log has outgrown the base
+/// [ cost scales with the number of dirty slots between compactions ]
+/// @param store the store to checkpoint
+/// @return true if checkpoint is durable on disk
+bool dtype_store_checkpoint(dtype_store * store)
+{
+    if ( store->compact || store->log_bytes >= store->base_bytes ) { return dtype_store_compact(store); }
+    size_t words = dtype__bitmap_words(store->count);
+    // frame header is filled in once the payload is known
+    dtype frame = dtype_builder(dtype_default(), DTYPE__STORE_FRAME_HEADER);
+    frame = dtype_append_bytes(frame, "DTLG\0\0\0\0", 8);
+    frame.length = DTYPE__STORE_FRAME_HEADER;
+    uint64_t entries = 0;
+    bool ok = frame.type == DTYPE_STRING_BUILDER && frame.size > DTYPE__STORE_FRAME_HEADER;
+    for ( size_t k = 0; ok && k < words; k++ ) {
+        for ( uint64_t bits = store->dirty[k]; ok && bits; bits &= bits - 1 ) {
+            size_t slot = k * 64 + dtype__ctz64(bits);
+            unsigned char index[DTYPE__RECORD_HEADER];
+            size_t size = dtype_record_encode(store->slots[slot], NULL, 0);
+            frame = dtype_append_bytes(frame, index, (size_t)(dtype__varint_write(index, slot) - index));
+            frame = dtype__builder_reserve(frame, size, "dtype_store_checkpoint");
+            ok = frame.size > frame.length + size;
+            if ( ok ) {
+                frame.length += dtype_record_encode(store->slots[slot], (char *)frame.mem + frame.length, size);
+                entries++;
+            }
+        }
+    }
+    if ( ok && entries ) {
+        unsigned char * head = frame.mem;
+        uint64_t seq = store->seq + 1, payload = frame.length - DTYPE__STORE_FRAME_HEADER;
+        uint64_t sum = dtype__hash_str((const char *)head + DTYPE__STORE_FRAME_HEADER, payload);
+        memcpy(head + 8, &seq, 8);
+        memcpy(head + 16, &entries, 8);
+        memcpy(head + 24, &payload, 8);
+        memcpy(head + 32, &sum, 8);
+        ok = dtype__write_all(store->log_fd, head, frame.length) && fdatasync(store->log_fd) == 0;
+        if ( !ok ) {
+            dtype__raise("dtype_store_checkpoint", "Couldn't write the log.\n", DTYPE_IO_ERROR);
+            // replay stops at a torn frame, so frames appended after one would be lost
+            store->compact = ftruncate(store->log_fd, (off_t)store->log_bytes) != 0;
+        } else {
+            store->seq = seq;
+            store->log_bytes += frame.length;
+            memset(store->dirty, 0, words * sizeof(uint64_t));
+        }
+    }
+    dtype_clear(frame);
+    return ok;
+}
+
+/// @brief write every slot as a new base & empty the log
+/// @param store the store to compact
+/// @return true if compaction is durable on disk
+bool dtype_store_compact(dtype_store * store)
+{
+    char * base = dtype__store_file(store->path, ".base");
+    char * tmp = dtype__store_file(store->path, ".base.tmp");
+    int fd = tmp ? open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) : -1;
+    dtype chunk = dtype_builder(dtype_default(), DTYPE__STORE_WRITE_CHUNK);
+    uint64_t seq = store->seq + 1, count = store->count;
+    size_t written = 0;
+    bool ok = base != NULL && fd >= 0 && chunk.type == DTYPE_STRING_BUILDER;
+    if ( ok ) {
+        chunk = dtype_append_bytes(chunk, "DTSTORE\0", 8);
+        chunk = dtype_append_bytes(chunk, &seq, 8);
+        chunk = dtype_append_bytes(chunk, &count, 8);
+        chunk = dtype_append_bytes(chunk, "\0\0\0\0\0\0\0\0", 8);
+    }
+    for ( size_t i = 0; ok && i <= store->count; i++ ) {
+        // write out whenever the chunk is full, and once more at the end
+        if ( chunk.length >= DTYPE__STORE_WRITE_CHUNK || i == store->count ) {
+            ok = dtype__write_all(fd, chunk.mem, chunk.length);
+            written += chunk.length;
+            chunk.length = 0;
+        }
+        if ( !ok || i == store->count ) { continue; }
+        size_t size = dtype_record_encode(store->slots[i], NULL, 0);
+        chunk = dtype__builder_reserve(chunk, size, "dtype_store_compact");
+        ok = chunk.size > chunk.length + size;
+        chunk.length += ok ? dtype_record_encode(store->slots[i], (char *)chunk.mem + chunk.length, size) : 0;
+    }
+    ok = ok && fsync(fd) == 0;
+    fd >= 0 ? close(fd) : 0;
+    // the rename makes the new base current, its sequence marks the old log frames as stale
+    ok = ok && rename(tmp, base) == 0;
+    if ( ok ) {
+        dtype__sync_dir(store->path);
+        store->seq = seq;
+        store->base_bytes = written;
+        memset(store->dirty, 0, dtype__bitmap_words(store->count) * sizeof(uint64_t));
+        // a log that can't be emptied may hold a torn frame, keep compacting until it is
+        store->compact = ftruncate(store->log_fd, 0) != 0;
+        store->log_bytes = store->compact ? store->log_bytes : 0;
+    } else {
+        dtype__raise("dtype_store_compact", "Couldn't write the base.\n", DTYPE_IO_ERROR);
+        tmp ? unlink(tmp) : 0;
+    }
+    dtype_clear(chunk);
+    free(base);
+    free(tmp);
+    return ok;
+}
+
+/// @brief free the store [ changes since the last checkpoint are not persisted ]
+/// @param store the store to close
+void dtype_store_close(dtype_store * store)
+{
+    for ( size_t i = 0; i < store->count; i++ ) { dtype_clear(store->slots[i]); }
+    store->log_fd >= 0 ? close(store->log_fd) : 0;
+    free(store->slots);
+    free(store->dirty);
+    free(store->path);
+    free(store);
+}
+
+#endif // DTYPE_POSIX_IO
@@ -3,36 +3,100 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+/// @brief set when the file & thread based parts ( writer, store ) are available
+/// [ programs linking dtype.c then need -lpthread on older glibc ]
+#define DTYPE_POSIX_IO 1
+#endif
 
 /// @brief enum containing the type which can be represented in dtype
+/// [ codes are stored in encoded blocks & records, so they never change : new types get new codes at the end ]
 enum DTYPE_TYPES {
-    DTYPE_NONE,
+    DTYPE_NONE = 0,
     /// @brief dtype_type indicating the type is boolean
-    DTYPE_BOOL,
+    DTYPE_BOOL = 1,
     /// @brief dtype_type indicating the type is character
-    DTYPE_CHAR,
+    DTYPE_CHAR = 2,
     /// @brief dtype_type indicating the type is short
-    DTYPE_SHORT,
+    DTYPE_SHORT = 3,
     /// @brief dtype_type indicating the type is unsigned short
-    DTYPE_USHORT,
+    DTYPE_USHORT = 4,
     /// @brief dtype_type indicating the type is int
-    DTYPE_INT,
+    DTYPE_INT = 5,
     /// @brief dtype_type indicating the type is unsigned int
-    DTYPE_UINT,
+    DTYPE_UINT = 6,
     /// @brief dtype_type indicating the type is long
-    DTYPE_LONG,
+    DTYPE_LONG = 7,
     /// @brief dtype_type indicating the type is unsigned long
-    DTYPE_ULONG,
+    DTYPE_ULONG = 8,
     /// @brief dtype_type indicating the type is float
-    DTYPE_FLOAT,
+    DTYPE_FLOAT = 9,
     /// @brief dtype_type indicating the type is double
-    DTYPE_DOUBLE,
+    DTYPE_DOUBLE = 10,
     /// @brief dtype_type indicating the type is string
-    DTYPE_STRING,
+    DTYPE_STRING = 11,
     /// @brief dtype_type indicating the type is a custom type
-    DTYPE_CUSTOM
+    DTYPE_CUSTOM = 12,
+    /// @brief dtype_type indicating the type is 8-bit signed integer
+    DTYPE_INT8 = 13,
+    /// @brief dtype_type indicating the type is 8-bit unsigned integer
+    DTYPE_UINT8 = 14,
+    /// @brief dtype_type indicating the type is 16-bit signed integer
+    DTYPE_INT16 = 15,
+    /// @brief dtype_type indicating the type is 16-bit unsigned integer
+    DTYPE_UINT16 = 16,
+    /// @brief dtype_type indicating the type is 32-bit signed integer
+    DTYPE_INT32 = 17,
+    /// @brief dtype_type indicating the type is 32-bit unsigned integer
+    DTYPE_UINT32 = 18,
+    /// @brief dtype_type indicating the type is 64-bit signed integer
+    DTYPE_INT64 = 19,
+    /// @brief dtype_type indicating the type is 64-bit unsigned integer
+    DTYPE_UINT64 = 20,
+    /// @brief dtype_type indicating the type is IEEE 754 half precision float [ stored as 16 bits ]
+    DTYPE_FLOAT16 = 21,
+    /// @brief dtype_type indicating the type is brain float [ upper 16 bits of a float ]
+    DTYPE_BFLOAT16 = 22,
+    /// @brief dtype_type indicating the type is string being built [ appendable, see dtype_builder ]
+    DTYPE_STRING_BUILDER = 23,
+    /// @brief not a type, one past the last type code [ for range checks ]
+    DTYPE_TYPES_END
+};
+
+
+/// @brief enum containing the element-wise arithmetic operations
+enum DTYPE_OPS {
+    /// @brief dtype_op adding elements
+    DTYPE_OP_ADD,
+    /// @brief dtype_op subtracting elements
+    DTYPE_OP_SUB,
+    /// @brief dtype_op multiplying elements
+    DTYPE_OP_MUL,
+    /// @brief dtype_op dividing elements [ integer division by zero gives null ]
+    DTYPE_OP_DIV,
+    /// @brief dtype_op taking the smaller element
+    DTYPE_OP_MIN,
+    /// @brief dtype_op taking the larger element
+    DTYPE_OP_MAX
 };
 
+/// @brief enum containing the element-wise comparisons
+enum DTYPE_CMPS {
+    /// @brief dtype_cmp checking equality
+    DTYPE_CMP_EQ,
+    /// @brief dtype_cmp checking inequality [ true for nan ]
+    DTYPE_CMP_NE,
+    /// @brief dtype_cmp checking less than
+    DTYPE_CMP_LT,
+    /// @brief dtype_cmp checking less than or equal
+    DTYPE_CMP_LE,
+    /// @brief dtype_cmp checking greater than
+    DTYPE_CMP_GT,
+    /// @brief dtype_cmp checking greater than or equal
+    DTYPE_CMP_GE
+};
 
 /// @brief the actual dtype definition
 typedef struct dtype {
@@ -40,10 +104,75 @@ typedef struct dtype {
     void * mem;
     /// @brief current size of allocated memory
     size_t size;
+    /// @brief length of content, excluding terminator [ only tracked for DTYPE_STRING_BUILDER ]
+    size_t length;
     /// @brief curremt type of data stored in dtype
     enum DTYPE_TYPES type;
 } dtype;
 
+/// @brief contiguous storage of values of a single dtype type [ a column ]
+typedef struct dtype_array {
+    /// @brief memory where the elements are stored. [ bit-packed words for DTYPE_BOOL ]
+    void * mem;
+    /// @brief validity bitmap, 1 bit per element, set bit means valid. [ NULL means all valid ]
+    uint64_t * valid;
+    /// @brief number of elements stored
+    size_t length;
+    /// @brief type of every element stored in the array
+    enum DTYPE_TYPES type;
+} dtype_array;
+
+/// @brief enum containing what a writer producer does when its buffer is full
+enum DTYPE_BACKPRESSURE {
+    /// @brief dtype_backpressure waiting for the flush thread to make room
+    DTYPE_BACKPRESSURE_BLOCK,
+    /// @brief dtype_backpressure dropping the record [ counted in stats ]
+    DTYPE_BACKPRESSURE_DROP,
+    /// @brief dtype_backpressure switching to a buffer of double the size
+    DTYPE_BACKPRESSURE_GROW
+};
+
+/// @brief asynchronous record writer [ opaque, see dtype_writer_open ]
+typedef struct dtype_writer dtype_writer;
+
+/// @brief buffer of a single producer thread of a writer [ opaque, see dtype_writer_producer ]
+typedef struct dtype_producer dtype_producer;
+
+/// @brief table of dtype values persisted with incremental checkpoints [ opaque, see dtype_store_open ]
+typedef struct dtype_store dtype_store;
+
+/// @brief metrics of a writer
+typedef struct dtype_writer_stats {
+    /// @brief bytes put by producers & not yet written to file
+    size_t queue_depth;
+    /// @brief records put by producers
+    uint64_t records;
+    /// @brief records dropped because the buffer was full
+    uint64_t dropped;
+    /// @brief number of times a producer buffer was grown
+    uint64_t grows;
+    /// @brief bytes written to file
+    uint64_t bytes_written;
+    /// @brief bytes thrown away because a write or sync of the file failed before
+    uint64_t bytes_discarded;
+    /// @brief number of flushes, i.e wakeups of the flush thread which wrote something
+    uint64_t flushes;
+    /// @brief duration of last flush in nanoseconds [ writes & sync if requested ]
+    uint64_t flush_ns_last;
+    /// @brief duration of longest flush in nanoseconds
+    uint64_t flush_ns_max;
+    /// @brief total duration of all flushes in nanoseconds
+    uint64_t flush_ns_total;
+} dtype_writer_stats;
+
+/// @brief a single step of an expression chain, i.e `result = result op operand`
+typedef struct dtype_expr_step {
+    /// @brief the operation to apply
+    enum DTYPE_OPS op;
+    /// @brief the right hand operand [ length 1 arrays are broadcast ]
+    dtype_array operand;
+} dtype_expr_step;
+
 enum DTYPE_ERRORS {
     /// @brief dtype_error indicating no error
     DTYPE_NO_ERROR,
@@ -53,10 +182,32 @@ enum DTYPE_ERRORS {
     DTYPE_WARN_ERROR,
     /// @brief dtype error indicating type error.
     DTYPE_TYPE_ERROR,
+    /// @brief dtype error indicating index out of range.
+    DTYPE_INDEX_ERROR,
+    /// @brief dtype error indicating invalid or corrupted encoded data.
+    DTYPE_FORMAT_ERROR,
+    /// @brief dtype error indicating failed file or thread operation.
+    DTYPE_IO_ERROR,
     /// @brief dtype_error indicating unknown error
     DTYPE_UNKNOWN_ERROR
 };
 
+/// @brief enum containing the block codecs which can be used to encode dtype columns
+enum DTYPE_CODECS {
+    /// @brief dtype_codec picking the codec from the type ( see dtype_codec_for_type )
+    DTYPE_CODEC_AUTO,
+    /// @brief dtype_codec storing the elements as is
+    DTYPE_CODEC_RAW,
+    /// @brief dtype_codec for integers, zigzag encoded deltas bit-packed per block
+    DTYPE_CODEC_DELTA,
+    /// @brief dtype_codec for integers, offsets from block minimum bit-packed per block ( frame of reference )
+    DTYPE_CODEC_FOR,
+    /// @brief dtype_codec for float & double, xor with previous value bit-packed per block ( gorilla style )
+    DTYPE_CODEC_XOR,
+    /// @brief dtype_codec for strings, dictionary of distinct strings & run length encoded ids
+    DTYPE_CODEC_DICT_RLE
+};
+
 
 // ------------------------------ Function Definitions -----------------------------------
 
@@ -153,6 +304,66 @@ dtype dtype_set_double(dtype var, double val);
 /// @return the dtype variable with value as given
 dtype dtype_set_string(dtype var, char * val);
 
+/// @brief set the value to 8-bit signed integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_int8(dtype var, int8_t val);
+
+/// @brief set the value to 8-bit unsigned integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_uint8(dtype var, uint8_t val);
+
+/// @brief set the value to 16-bit signed integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_int16(dtype var, int16_t val);
+
+/// @brief set the value to 16-bit unsigned integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_uint16(dtype var, uint16_t val);
+
+/// @brief set the value to 32-bit signed integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_int32(dtype var, int32_t val);
+
+/// @brief set the value to 32-bit unsigned integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_uint32(dtype var, uint32_t val);
+
+/// @brief set the value to 64-bit signed integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_int64(dtype var, int64_t val);
+
+/// @brief set the value to 64-bit unsigned integer
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_uint64(dtype var, uint64_t val);
+
+/// @brief set the value to half precision float [ rounded to nearest even ]
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_float16(dtype var, float val);
+
+/// @brief set the value to brain float [ rounded to nearest even ]
+/// @param var the dtype variable to set to
+/// @param val the value to set to
+/// @return the dtype variable with value as given
+dtype dtype_set_bfloat16(dtype var, float val);
+
 /// @brief clear the variable, i.e set it to none
 /// @param var the variable to clear
 /// @return the cleared variable
@@ -222,4 +433,391 @@ double dtype_get_double(dtype var);
 /// @return the value of given dtype variable as a string
 char * dtype_get_string(dtype var);
 
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 8-bit signed integer
+int8_t dtype_get_int8(dtype var);
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 8-bit unsigned integer
+uint8_t dtype_get_uint8(dtype var);
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 16-bit signed integer
+int16_t dtype_get_int16(dtype var);
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 16-bit unsigned integer
+uint16_t dtype_get_uint16(dtype var);
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 32-bit signed integer
+int32_t dtype_get_int32(dtype var);
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 32-bit unsigned integer
+uint32_t dtype_get_uint32(dtype var);
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 64-bit signed integer
+int64_t dtype_get_int64(dtype var);
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable as 64-bit unsigned integer
+uint64_t dtype_get_uint64(dtype var);
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable (half precision) widened to float
+float dtype_get_float16(dtype var);
+
+/// @brief get the value of dtype variable
+/// @param var the dtype variable to get from
+/// @return the value of given dtype variable (brain float) widened to float
+float dtype_get_bfloat16(dtype var);
+
+// ----------- Conversion Functions ------------
+
+/// @brief bulk convert floats to half precision [ uses F16C when the cpu supports it ]
+/// @param dst destination array of `count` half precision values ( as raw 16 bits )
+/// @param src source array of `count` floats
+/// @param count number of elements to convert
+void dtype_float_to_float16(uint16_t * dst, const float * src, size_t count);
+
+/// @brief bulk convert half precision values to floats [ uses F16C when the cpu supports it ]
+/// @param dst destination array of `count` floats
+/// @param src source array of `count` half precision values ( as raw 16 bits )
+/// @param count number of elements to convert
+void dtype_float16_to_float(float * dst, const uint16_t * src, size_t count);
+
+/// @brief bulk convert floats to brain floats [ uses AVX2 when the cpu supports it ]
+/// @param dst destination array of `count` brain float values ( as raw 16 bits )
+/// @param src source array of `count` floats
+/// @param count number of elements to convert
+void dtype_float_to_bfloat16(uint16_t * dst, const float * src, size_t count);
+
+/// @brief bulk convert brain floats to floats [ uses AVX2 when the cpu supports it ]
+/// @param dst destination array of `count` floats
+/// @param src source array of `count` brain float values ( as raw 16 bits )
+/// @param count number of elements to convert
+void dtype_bfloat16_to_float(float * dst, const uint16_t * src, size_t count);
+
+// ----------- Array Functions ------------
+
+/// @brief get the size of a single element of given type
+/// @param type the type to get size of
+/// @return size in bytes, 0 for types without fixed size ( none, string, custom )
+size_t dtype_type_size(enum DTYPE_TYPES type);
+
+/// @brief Returns a null, but initialized dtype array
+/// @return initialized dtype array
+dtype_array dtype_array_default();
+
+/// @brief create a zero filled array of given type and length [ booleans are bit-packed ]
+/// @param type the type of elements, must have a fixed size ( see dtype_type_size ) or be DTYPE_BOOL
+/// @param length number of elements
+/// @return the created array, or default array on error
+dtype_array dtype_array_new(enum DTYPE_TYPES type, size_t length);
+
+/// @brief clear the array, i.e free elements & validity bitmap
+/// @param arr the array to clear
+/// @return the cleared array
+dtype_array dtype_array_clear(dtype_array arr);
+
+/// @brief set the value of element at index [ a DTYPE_NONE value marks the element as null ]
+/// @param arr the array to set in
+/// @param index the index of element
+/// @param val the value to set to, must be of the same type as the array
+/// @return the array with value as given [ validity bitmap may get allocated ]
+dtype_array dtype_array_set(dtype_array arr, size_t index, dtype val);
+
+/// @brief get the value of element at index
+/// @param arr the array to get from
+/// @param index the index of element
+/// @param var the dtype variable to store value in
+/// @return the dtype variable with value of element, or cleared variable if element is null
+dtype dtype_array_get(dtype_array arr, size_t index, dtype var);
+
+/// @brief mark the element at index valid or null
+/// @param arr the array to mark in
+/// @param index the index of element
+/// @param valid false to mark as null
+/// @return the array with validity as given [ validity bitmap gets allocated on first null ]
+dtype_array dtype_array_set_valid(dtype_array arr, size_t index, bool valid);
+
+/// @brief check if element at index is valid ( not null )
+/// @param arr the array to check in
+/// @param index the index of element
+/// @return true if element is valid
+bool dtype_array_is_valid(dtype_array arr, size_t index);
+
+/// @brief count the null elements in array [ popcount of the validity bitmap ]
+/// @param arr the array to count in
+/// @return number of null elements
+size_t dtype_array_null_count(dtype_array arr);
+
+/// @brief count the elements of a boolean array which are valid and true
+/// @param mask the boolean array to count in
+/// @return number of valid true elements
+size_t dtype_array_count_true(dtype_array mask);
+
+/// @brief element-wise and of two boolean arrays [ null if either is null ]
+/// @param a first boolean array
+/// @param b second boolean array, of same length
+/// @return new boolean array with the result
+dtype_array dtype_array_mask_and(dtype_array a, dtype_array b);
+
+/// @brief element-wise or of two boolean arrays [ null if either is null ]
+/// @param a first boolean array
+/// @param b second boolean array, of same length
+/// @return new boolean array with the result
+dtype_array dtype_array_mask_or(dtype_array a, dtype_array b);
+
+/// @brief element-wise not of a boolean array [ nulls stay null ]
+/// @param a the boolean array
+/// @return new boolean array with the result
+dtype_array dtype_array_mask_not(dtype_array a);
+
+/// @brief keep only the elements for which mask is valid and true
+/// @param arr the array to filter
+/// @param mask boolean array of same length
+/// @return new array with the kept elements [ validity of kept elements is preserved ]
+dtype_array dtype_array_filter(dtype_array arr, dtype_array mask);
+
+/// @brief pick elements from `a` where mask is valid and true, else from `b`
+/// @param mask boolean array
+/// @param a array to pick from where mask is true
+/// @param b array to pick from otherwise, of same type & length as `a`
+/// @return new array with the picked elements [ validity is picked along with values ]
+dtype_array dtype_array_select(dtype_array mask, dtype_array a, dtype_array b);
+
+/// @brief prints the content of dtype array as a list
+/// @param arr the array to print
+/// @return the number of characters printed
+int dtype_array_print(dtype_array arr);
+
+// ----------- Codec Functions ------------
+
+/// @brief get the codec used for given type by DTYPE_CODEC_AUTO
+/// @param type the type of column
+/// @return delta for integers, xor for float & double, dict rle for string, raw for the rest
+enum DTYPE_CODECS dtype_codec_for_type(enum DTYPE_TYPES type);
+
+/// @brief encode an array into a self describing block [ validity bitmap is kept ]
+/// @param arr the array to encode
+/// @param codec the codec to use, must suit the type of array
+/// @param out the dtype variable to store the encoded bytes in
+/// @return the dtype variable ( DTYPE_CUSTOM ) with the encoded block, or cleared variable on error
+dtype dtype_array_encode(dtype_array arr, enum DTYPE_CODECS codec, dtype out);
+
+/// @brief decode a block created by dtype_array_encode [ uses AVX2 when the cpu supports it ]
+/// @param mem pointer to the encoded block
+/// @param size size of the encoded block
+/// @return the decoded array, or default array on error
+dtype_array dtype_array_decode(const void * mem, size_t size);
+
+/// @brief encode string values with DTYPE_CODEC_DICT_RLE [ DTYPE_NONE values are kept as null ]
+/// @param vals the values to encode, each must be a string or none
+/// @param count number of values
+/// @param out the dtype variable to store the encoded bytes in
+/// @return the dtype variable ( DTYPE_CUSTOM ) with the encoded block, or cleared variable on error
+dtype dtype_strings_encode(const dtype * vals, size_t count, dtype out);
+
+/// @brief decode a block created by dtype_strings_encode
+/// @param mem pointer to the encoded block
+/// @param size size of the encoded block
+/// @param count set to the number of decoded values
+/// @return malloc'd array of values [ clear each & free the array ], or NULL on error
+dtype * dtype_strings_decode(const void * mem, size_t size, size_t * count);
+
+// ----------- Arithmetic Functions ------------
+
+/// @brief get the type two types are promoted to in arithmetic
+/// @param a type of left operand
+/// @param b type of right operand
+/// @return the promoted type, or DTYPE_NONE if either type is not numeric
+/// [ same types stay as is, booleans act as uint8, floats with 32 & 64 bit integers become double,
+///   mixed signedness picks a signed type wider than the unsigned one (up to int64),
+///   otherwise the larger of the two ( as a fixed width type ) ]
+enum DTYPE_TYPES dtype_promote(enum DTYPE_TYPES a, enum DTYPE_TYPES b);
+
+/// @brief create a length 1 array holding the value, to be broadcast as operand
+/// @param val the numeric value
+/// @return the created array, or default array on error
+dtype_array dtype_array_scalar(dtype val);
+
+/// @brief element-wise arithmetic `out = a op b` [ uses AVX2 when the cpu supports it ]
+/// @param op the operation
+/// @param a left operand [ length 1 arrays are broadcast ]
+/// @param b right operand [ length 1 arrays are broadcast ]
+/// @param out array to store result in, reused if it already has result type & length, freed otherwise [ may be `a` or `b` ]
+/// @return the result array of promoted type, null where any operand is null
+dtype_array dtype_binop(enum DTYPE_OPS op, dtype_array a, dtype_array b, dtype_array out);
+
+/// @brief evaluate `((first op1 operand1) op2 operand2) ...` in one pass without intermediate arrays
+/// @param first the first operand [ length 1 arrays are broadcast ]
+/// @param steps the operations & operands applied in order
+/// @param count number of steps
+/// @param out array to store result in, reused if it already has result type & length, freed otherwise
+/// @return the result array of type promoted over all operands, null where any operand is null
+dtype_array dtype_binop_chain(dtype_array first, const dtype_expr_step * steps, size_t count, dtype_array out);
+
+/// @brief element-wise comparison `out_mask = a cmp b` [ uses AVX2 when the cpu supports it ]
+/// @param op the comparison
+/// @param a left operand [ length 1 arrays are broadcast ]
+/// @param b right operand [ length 1 arrays are broadcast ]
+/// @param out_mask boolean array to store result in, reused if it already has the length, freed otherwise
+/// @return the boolean result array, null where any operand is null
+dtype_array dtype_cmp(enum DTYPE_CMPS op, dtype_array a, dtype_array b, dtype_array out_mask);
+
+// ----------- Builder Functions ------------
+
+/// @brief switch the variable to builder mode with room for at least `capacity` bytes
+/// [ a string is taken over without copying, any other type is replaced by an empty builder ]
+/// @param var the dtype variable to switch
+/// @param capacity number of bytes to reserve for content
+/// @return the dtype variable in builder mode
+dtype dtype_builder(dtype var, size_t capacity);
+
+/// @brief append a string to builder [ strings & empty none values are switched to builder mode first ]
+/// @param var the dtype variable to append to
+/// @param str the string to append
+/// @return the dtype variable with the string appended
+dtype dtype_append_str(dtype var, const char * str);
+
+/// @brief append bytes to builder [ strings & empty none values are switched to builder mode first ]
+/// @param var the dtype variable to append to
+/// @param bytes the bytes to append, may point into the builder itself
+/// @param size number of bytes to append
+/// @return the dtype variable with the bytes appended
+dtype dtype_append_bytes(dtype var, const void * bytes, size_t size);
+
+/// @brief append printf style formatted text to builder [ strings & empty none values are switched to builder mode first ]
+/// @param var the dtype variable to append to
+/// @param fmt the printf format
+/// @return the dtype variable with the formatted text appended
+dtype dtype_appendf(dtype var, const char * fmt, ...);
+
+/// @brief append the value formatted as dtype_print does [ strings & empty none values are switched to builder mode first ]
+/// @param var the dtype variable to append to
+/// @param val the value to append
+/// @return the dtype variable with the value appended
+dtype dtype_append_value(dtype var, dtype val);
+
+/// @brief finish the builder, turning it into a string without copying
+/// @param var the builder to finish
+/// @return the dtype variable as DTYPE_STRING
+dtype dtype_builder_finish(dtype var);
+
+// ----------- Record Functions ------------
+
+/// @brief encode the value as a record : type byte, varint payload size & payload
+/// [ builders are encoded as strings ]
+/// @param val the value to encode
+/// @param mem memory to write the record to, written only if the record fits
+/// @param size size of memory
+/// @return the size of the record, 0 if value can't be encoded
+size_t dtype_record_encode(dtype val, void * mem, size_t size);
+
+/// @brief decode a record created by dtype_record_encode
+/// @param mem pointer to the record
+/// @param size number of bytes available
+/// @param used set to the size of record, 0 if record is invalid or truncated
+/// @param var the dtype variable to store value in
+/// @return the dtype variable with the decoded value
+dtype dtype_record_decode(const void * mem, size_t size, size_t * used, dtype var);
+
+#if defined(DTYPE_POSIX_IO)
+
+// ----------- Writer Functions ------------
+
+/// @brief open an asynchronous writer appending records to a file from a background flush thread
+/// @param path the file to append to, created if it doesn't exist
+/// @param buffer_size starting size of the buffer of each producer [ rounded up to power of 2 ]
+/// @param policy what producers do when their buffer is full
+/// @return the writer, or NULL on error
+dtype_writer * dtype_writer_open(const char * path, size_t buffer_size, enum DTYPE_BACKPRESSURE policy);
+
+/// @brief get a producer buffer for the calling thread [ each producer must only be used by one thread ]
+/// @param writer the writer to produce for
+/// @return the producer, or NULL on error [ lives until released or the writer is closed ]
+dtype_producer * dtype_writer_producer(dtype_writer * writer);
+
+/// @brief hand the producer back once its thread stops putting, for a later dtype_writer_producer to reuse
+/// [ records already put are still written ]
+/// @param producer the producer of calling thread
+void dtype_writer_release_producer(dtype_producer * producer);
+
+/// @brief queue the value as a record, never waits for file writes [ except for DTYPE_BACKPRESSURE_BLOCK when full ]
+/// @param producer the producer of calling thread
+/// @param val the value to queue
+/// @return true if queued, false if dropped or on error
+bool dtype_writer_put(dtype_producer * producer, dtype val);
+
+/// @brief wait until every record queued before the call is written & synced to file
+/// @param writer the writer to flush
+/// @return true if every record so far reached the file, false once a write or sync failed
+bool dtype_writer_flush(dtype_writer * writer);
+
+/// @brief flush, stop the flush thread & free the writer [ producers must have stopped putting ]
+/// @param writer the writer to close
+/// @return true if every record reached the file, false once a write or sync failed
+bool dtype_writer_close(dtype_writer * writer);
+
+/// @brief get the metrics of writer
+/// @param writer the writer to get metrics of
+/// @return the current metrics
+dtype_writer_stats dtype_writer_get_stats(dtype_writer * writer);
+
+// ----------- Store Functions ------------
+
+/// @brief open a store of values, recovering it from `path`.base & replaying `path`.log if they exist
+/// @param path prefix of the store files
+/// @param slots number of slots, grown further if the recovered store has more
+/// @return the store, or NULL on error
+dtype_store * dtype_store_open(const char * path, size_t slots);
+
+/// @brief get the number of slots in store
+/// @param store the store
+/// @return number of slots
+size_t dtype_store_slots(dtype_store * store);
+
+/// @brief set the value of slot & mark it dirty for the next checkpoint
+/// @param store the store to set in
+/// @param slot index of slot
+/// @param val the value to copy into slot [ builders are stored as strings ]
+/// @return true if set
+bool dtype_store_set(dtype_store * store, size_t slot, dtype val);
+
+/// @brief get the value of slot
+/// @param store the store to get from
+/// @param slot index of slot
+/// @param var the dtype variable to copy value into
+/// @return the dtype variable with value of slot
+dtype dtype_store_get(dtype_store * store, size_t slot, dtype var);
+
+/// @brief persist the dirty slots as a delta, or compact when the log has outgrown the base
+/// [ cost scales with the number of dirty slots between compactions ]
+/// @param store the store to checkpoint
+/// @return true if checkpoint is durable on disk
+bool dtype_store_checkpoint(dtype_store * store);
+
+/// @brief write every slot as a new base & empty the log
+/// @param store the store to compact
+/// @return true if compaction is durable on disk
+bool dtype_store_compact(dtype_store * store);
+
+/// @brief free the store [ changes since the last checkpoint are not persisted ]
+/// @param store the store to close
+void dtype_store_close(dtype_store * store);
+
+#endif // DTYPE_POSIX_IO
+
 #endif // DTYPE_H_INCL
\ No newline at end of file
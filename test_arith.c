@@ -0,0 +1,116 @@
+#include <dtype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_check.h"
+
+// arithmetic checks : results against element by element computation, nulls, broadcasts & reuse of out
+// build : gcc -O2 -I. test_arith.c dtype.c -o test_arith -lpthread && ./test_arith [ -fsanitize=address also finds leaks ]
+
+/// @brief number of elements, spanning a few chunks & not a multiple of the vector width
+#define TEST_LENGTH 1001
+
+/// @brief int32 array of small random values [ every 7th is zero ]
+dtype_array test_ints(size_t length)
+{
+    dtype_array arr = dtype_array_new(DTYPE_INT32, length);
+    for ( size_t i = 0; i < length; i++ ) { ((int32_t *)arr.mem)[i] = i % 7 ? rand() % 2001 - 1000 : 0; }
+    return arr;
+}
+
+/// @brief int32 arithmetic & comparison against scalar results, division by zero gives null
+void test_int32()
+{
+    dtype_array a = test_ints(TEST_LENGTH), b = test_ints(TEST_LENGTH);
+    a = dtype_array_set_valid(a, 5, false);
+    const int32_t * x = a.mem, * y = b.mem;
+    for ( int op = DTYPE_OP_ADD; op <= DTYPE_OP_MAX; op++ ) {
+        dtype_array out = dtype_binop(op, a, b, dtype_array_default());
+        CHECK(out.type == DTYPE_INT32 && out.length == TEST_LENGTH);
+        size_t mismatches = 0;
+        for ( size_t i = 0; out.type == DTYPE_INT32 && i < TEST_LENGTH; i++ ) {
+            bool zero = op == DTYPE_OP_DIV && y[i] == 0;
+            int32_t ref = op == DTYPE_OP_ADD ? x[i] + y[i] : op == DTYPE_OP_SUB ? x[i] - y[i]
+                : op == DTYPE_OP_MUL ? x[i] * y[i] : op == DTYPE_OP_DIV ? ( zero ? 0 : x[i] / y[i] )
+                : op == DTYPE_OP_MIN ? ( x[i] < y[i] ? x[i] : y[i] ) : ( x[i] > y[i] ? x[i] : y[i] );
+            bool valid = i != 5 && !zero;
+            mismatches += dtype_array_is_valid(out, i) != valid || (valid && ((int32_t *)out.mem)[i] != ref);
+        }
+        CHECK(mismatches == 0);
+        dtype_array_clear(out);
+    }
+    for ( int op = DTYPE_CMP_EQ; op <= DTYPE_CMP_GE; op++ ) {
+        dtype_array mask = dtype_cmp(op, a, b, dtype_array_default());
+        CHECK(mask.type == DTYPE_BOOL && mask.length == TEST_LENGTH);
+        size_t mismatches = 0;
+        for ( size_t i = 0; mask.type == DTYPE_BOOL && i < TEST_LENGTH; i++ ) {
+            bool ref = op == DTYPE_CMP_EQ ? x[i] == y[i] : op == DTYPE_CMP_NE ? x[i] != y[i]
+                : op == DTYPE_CMP_LT ? x[i] < y[i] : op == DTYPE_CMP_LE ? x[i] <= y[i]
+                : op == DTYPE_CMP_GT ? x[i] > y[i] : x[i] >= y[i];
+            bool bit = (((uint64_t *)mask.mem)[i / 64] >> (i % 64)) & 1;
+            mismatches += dtype_array_is_valid(mask, i) != (i != 5) || (i != 5 && bit != ref);
+        }
+        CHECK(mismatches == 0);
+        dtype_array_clear(mask);
+    }
+    dtype_array_clear(a);
+    dtype_array_clear(b);
+}
+
+/// @brief a length 1 operand is broadcast, a null one makes everything null
+void test_broadcast()
+{
+    dtype_array a = test_ints(TEST_LENGTH), one = dtype_array_new(DTYPE_DOUBLE, 1);
+    ((double *)one.mem)[0] = 0.5;
+    dtype_array out = dtype_binop(DTYPE_OP_MUL, a, one, dtype_array_default());
+    CHECK(out.type == DTYPE_DOUBLE && out.length == TEST_LENGTH && dtype_array_null_count(out) == 0);
+    size_t mismatches = 0;
+    for ( size_t i = 0; out.type == DTYPE_DOUBLE && i < TEST_LENGTH; i++ ) {
+        mismatches += ((double *)out.mem)[i] != ((int32_t *)a.mem)[i] * 0.5;
+    }
+    CHECK(mismatches == 0);
+    one = dtype_array_set_valid(one, 0, false);
+    out = dtype_binop(DTYPE_OP_ADD, a, one, out);
+    CHECK(dtype_array_null_count(out) == TEST_LENGTH);
+    dtype_array_clear(out);
+    dtype_array_clear(one);
+    dtype_array_clear(a);
+}
+
+/// @brief out is reused when it fits, replaced & freed when it doesn't, also when it is an operand
+void test_reuse()
+{
+    dtype_array a = test_ints(TEST_LENGTH), b = test_ints(TEST_LENGTH);
+    dtype_array out = dtype_array_new(DTYPE_INT32, TEST_LENGTH);
+    void * mem = out.mem;
+    out = dtype_binop(DTYPE_OP_ADD, a, b, out);
+    CHECK(out.mem == mem);
+    // int8 out doesn't fit an int32 result, the old one is freed [ leak otherwise ]
+    dtype_array small = dtype_array_new(DTYPE_INT8, 37);
+    small = dtype_binop(DTYPE_OP_SUB, a, b, small);
+    CHECK(small.type == DTYPE_INT32 && small.length == TEST_LENGTH);
+    small = dtype_cmp(DTYPE_CMP_LT, a, small, small);
+    CHECK(small.type == DTYPE_BOOL && small.length == TEST_LENGTH);
+    // x = x op y, in place and with a type change
+    int32_t first = ((int32_t *)a.mem)[1] + ((int32_t *)b.mem)[1];
+    a = dtype_binop(DTYPE_OP_ADD, a, b, a);
+    CHECK(((int32_t *)a.mem)[1] == first);
+    dtype_array half = dtype_array_new(DTYPE_FLOAT, 1);
+    ((float *)half.mem)[0] = 0.5f;
+    a = dtype_binop(DTYPE_OP_MUL, a, half, a);
+    CHECK(a.type == DTYPE_DOUBLE && ((double *)a.mem)[1] == first * 0.5);
+    dtype_array_clear(half);
+    dtype_array_clear(small);
+    dtype_array_clear(out);
+    dtype_array_clear(a);
+    dtype_array_clear(b);
+}
+
+int main()
+{
+    srand(7);
+    test_int32();
+    test_broadcast();
+    test_reuse();
+    return test_done("test_arith");
+}
@@ -0,0 +1,164 @@
+#include <dtype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_check.h"
+
+// builder checks : growth, self appends, both formatting paths, values of every type & finishing
+// build : gcc -O2 -I. test_builder.c dtype.c -o test_builder -lpthread && ./test_builder
+
+/// @brief check the builder invariants : builder type, terminated content of `length` bytes within size
+bool test_valid(dtype var)
+{
+    return var.type == DTYPE_STRING_BUILDER && var.length < var.size && strlen(var.mem) == var.length;
+}
+
+/// @brief many appends grow capacity geometrically, length always matching content
+void test_growth()
+{
+    dtype var = dtype_builder(dtype_default(), 0);
+    size_t regrows = 0, bad = 0, size = var.size;
+    char expect[32];
+    size_t total = 0;
+    for ( int i = 0; i < 20000; i++ ) {
+        var = dtype_appendf(var, "%d,", i);
+        total += (size_t)snprintf(expect, sizeof(expect), "%d,", i);
+        bad += !test_valid(var) || var.length != total;
+        if ( var.size != size ) {
+            // capacity at least doubles
+            bad += var.size < size * 2;
+            size = var.size;
+            regrows++;
+        }
+    }
+    CHECK(bad == 0);
+    CHECK(regrows > 0 && regrows <= 20);
+    CHECK(strncmp(var.mem, "0,1,2,3,", 8) == 0 && strcmp((char *)var.mem + var.length - 6, "19999,") == 0);
+    dtype_clear(var);
+}
+
+/// @brief appending the builder to itself works across a regrow
+void test_self_append()
+{
+    dtype var = dtype_append_str(dtype_default(), "abc");
+    size_t bad = 0;
+    for ( int i = 0; i < 10; i++ ) {
+        var = dtype_append_bytes(var, var.mem, var.length);
+        bad += !test_valid(var) || var.length != (size_t)3 << (i + 1);
+    }
+    for ( size_t i = 0; i < var.length; i++ ) { bad += ((char *)var.mem)[i] != "abc"[i % 3]; }
+    CHECK(bad == 0);
+    dtype_clear(var);
+}
+
+/// @brief formatted appends fitting the spare capacity don't move memory, longer ones regrow once
+void test_format_paths()
+{
+    dtype var = dtype_builder(dtype_default(), 100);
+    void * mem = var.mem;
+    size_t size = var.size;
+    var = dtype_appendf(var, "%s-%d", "spare", 42);
+    CHECK(var.mem == mem && var.size == size && test_valid(var) && strcmp(var.mem, "spare-42") == 0);
+    char long_text[300];
+    memset(long_text, 'y', sizeof(long_text) - 1);
+    long_text[sizeof(long_text) - 1] = '\0';
+    var = dtype_appendf(var, "[%s]", long_text);
+    CHECK(var.size > size && test_valid(var) && var.length == 8 + 2 + 299);
+    CHECK(((char *)var.mem)[8] == '[' && ((char *)var.mem)[var.length - 1] == ']');
+    dtype_clear(var);
+}
+
+/// @brief a value of given type & the text dtype_append_value gives for it
+dtype test_value(enum DTYPE_TYPES type, const char ** text)
+{
+    dtype var = dtype_default();
+    int custom = 5;
+    switch ( type )
+    {
+        case DTYPE_NONE: *text = "none"; return var;
+        case DTYPE_BOOL: *text = "true"; return dtype_set_bool(var, true);
+        case DTYPE_CHAR: *text = "c"; return dtype_set_char(var, 'c');
+        case DTYPE_SHORT: *text = "-3"; return dtype_set_short(var, -3);
+        case DTYPE_USHORT: *text = "3"; return dtype_set_ushort(var, 3);
+        case DTYPE_INT: *text = "-70000"; return dtype_set_int(var, -70000);
+        case DTYPE_UINT: *text = "70000"; return dtype_set_uint(var, 70000);
+        case DTYPE_LONG: *text = "-5000000000"; return dtype_set_long(var, -5000000000L);
+        case DTYPE_ULONG: *text = "5000000000"; return dtype_set_ulong(var, 5000000000UL);
+        case DTYPE_FLOAT: *text = "1.500000"; return dtype_set_float(var, 1.5f);
+        case DTYPE_DOUBLE: *text = "-2.250000"; return dtype_set_double(var, -2.25);
+        case DTYPE_STRING: *text = "text"; return dtype_set_string(var, "text");
+        case DTYPE_CUSTOM: *text = "dtype_custom_variable"; return dtype_set_custom(var, &custom, sizeof(custom));
+        case DTYPE_INT8: *text = "-128"; return dtype_set_int8(var, -128);
+        case DTYPE_UINT8: *text = "255"; return dtype_set_uint8(var, 255);
+        case DTYPE_INT16: *text = "-32768"; return dtype_set_int16(var, -32768);
+        case DTYPE_UINT16: *text = "65535"; return dtype_set_uint16(var, 65535);
+        case DTYPE_INT32: *text = "-2147483648"; return dtype_set_int32(var, INT32_MIN);
+        case DTYPE_UINT32: *text = "4294967295"; return dtype_set_uint32(var, UINT32_MAX);
+        case DTYPE_INT64: *text = "-9223372036854775808"; return dtype_set_int64(var, INT64_MIN);
+        case DTYPE_UINT64: *text = "18446744073709551615"; return dtype_set_uint64(var, UINT64_MAX);
+        case DTYPE_FLOAT16: *text = "0.500000"; return dtype_set_float16(var, 0.5f);
+        case DTYPE_BFLOAT16: *text = "-4.000000"; return dtype_set_bfloat16(var, -4.0f);
+        case DTYPE_STRING_BUILDER: *text = "built"; return dtype_append_str(var, "built");
+        default: *text = ""; return var;
+    }
+}
+
+/// @brief every type code is appended as its text
+void test_values()
+{
+    for ( int type = DTYPE_NONE; type < DTYPE_TYPES_END; type++ ) {
+        const char * text;
+        dtype val = test_value(type, &text);
+        CHECK(val.type == (enum DTYPE_TYPES)type);
+        dtype var = dtype_append_str(dtype_default(), "=");
+        var = dtype_append_value(var, val);
+        bool same = test_valid(var) && strcmp((char *)var.mem + 1, text) == 0;
+        if ( !same ) { fprintf(stderr, "type %d appended as `%s`, not `%s`\n", type, (char *)var.mem, text); }
+        CHECK(same);
+        dtype_clear(var);
+        dtype_clear(val);
+    }
+}
+
+/// @brief shrinking cuts the content with its terminator, finishing keeps the memory
+void test_resize_finish()
+{
+    dtype var = dtype_append_str(dtype_default(), "hello world");
+    var = dtype_change_size(var, 6);
+    CHECK(test_valid(var) && var.size == 6 && var.length == 5 && strcmp(var.mem, "hello") == 0);
+    var = dtype_append_str(var, ", again");
+    CHECK(test_valid(var) && strcmp(var.mem, "hello, again") == 0);
+    void * mem = var.mem;
+    var = dtype_builder_finish(var);
+    CHECK(var.type == DTYPE_STRING && var.mem == mem && strcmp(dtype_get_string(var), "hello, again") == 0);
+    // a string is taken over as builder without copying either
+    var = dtype_builder(var, 0);
+    CHECK(test_valid(var) && var.mem == mem && var.length == 12);
+    dtype_clear(var);
+}
+
+/// @brief a none value holding memory is data, appending to it is refused
+void test_none_with_data()
+{
+    dtype var = dtype_change_size(dtype_default(), sizeof(int));
+    *(int *)var.mem = 1234;
+    var = dtype_append_str(var, "lost?");
+    CHECK(var.type == DTYPE_NONE && var.mem != NULL && *(int *)var.mem == 1234);
+    var = dtype_appendf(var, "%d", 1);
+    CHECK(var.type == DTYPE_NONE && *(int *)var.mem == 1234);
+    dtype_clear(var);
+    var = dtype_append_str(dtype_clear(dtype_default()), "empty");
+    CHECK(test_valid(var) && strcmp(var.mem, "empty") == 0);
+    dtype_clear(var);
+}
+
+int main()
+{
+    test_growth();
+    test_self_append();
+    test_format_paths();
+    test_values();
+    test_resize_finish();
+    test_none_with_data();
+    return test_done("test_builder");
+}
@@ -0,0 +1,26 @@
+#if !defined(TEST_CHECK_H_INCL)
+#define TEST_CHECK_H_INCL
+
+#include <stdio.h>
+
+/// @brief set when the x86 SIMD kernels of dtype.c are compiled in [ same condition as dtype.c ]
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define TEST_X86_SIMD 1
+#endif
+
+/// @brief number of failed checks in the test program
+static int test_failures;
+
+/// @brief check the condition, printing it with its location when false
+#define CHECK(cond) \
+    ( (cond) ? (void)0 : (test_failures++, (void)fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond)) )
+
+/// @brief print the result of the test program
+/// @return exit code of the test program
+static int test_done(const char * name)
+{
+    printf("%s: %s\n", name, test_failures ? "FAILED" : "ok");
+    return test_failures ? 1 : 0;
+}
+
+#endif // TEST_CHECK_H_INCL
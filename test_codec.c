@@ -0,0 +1,201 @@
+#include <dtype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_check.h"
+
+// codec checks : round trips at block boundaries & rejection of truncated or mismatched blocks
+// build : gcc -O2 -I. test_codec.c dtype.c -o test_codec -lpthread && ./test_codec
+
+/// @brief lengths around the 128 values of a codec block
+const size_t test_lengths[] = { 0, 1, 127, 128, 129, 1000 };
+
+/// @brief random 64-bit value
+uint64_t test_rand64()
+{
+    uint64_t x = 0;
+    for ( int i = 0; i < 4; i++ ) { x = (x << 16) ^ (uint64_t)(rand() & 0xffff); }
+    return x;
+}
+
+/// @brief array of random values, some slowly changing & some extreme, with nulls when asked
+dtype_array test_array(enum DTYPE_TYPES type, size_t length, bool nulls)
+{
+    dtype_array arr = dtype_array_new(type, length);
+    size_t size = dtype_type_size(type);
+    uint64_t walk = test_rand64();
+    if ( type == DTYPE_BOOL ) {
+        for ( size_t i = 0; i < length; i++ ) { ((uint64_t *)arr.mem)[i / 64] |= (test_rand64() & 1) << (i % 64); }
+    }
+    for ( size_t i = 0; type != DTYPE_BOOL && i < length; i++ ) {
+        walk += i % 7 == 0 ? test_rand64() : test_rand64() % 16;
+        if ( type == DTYPE_DOUBLE ) {
+            double val = i % 11 ? (double)(walk % 1000) * 0.25 : -1e300;
+            memcpy((char *)arr.mem + i * size, &val, size);
+        } else if ( type == DTYPE_FLOAT ) {
+            float val = i % 11 ? (float)(walk % 1000) * 0.5f : 3e38f;
+            memcpy((char *)arr.mem + i * size, &val, size);
+        } else {
+            memcpy((char *)arr.mem + i * size, &walk, size);
+        }
+    }
+    for ( size_t i = 0; nulls && i < length; i += 3 ) { arr = dtype_array_set_valid(arr, i, false); }
+    return arr;
+}
+
+/// @brief check two arrays have the same type, length, values & nulls
+bool test_same(dtype_array a, dtype_array b)
+{
+    size_t bytes = a.type == DTYPE_BOOL ? (a.length + 63) / 64 * 8 : a.length * dtype_type_size(a.type);
+    if ( a.type != b.type || a.length != b.length || (bytes && memcmp(a.mem, b.mem, bytes) != 0) ) { return false; }
+    for ( size_t i = 0; i < a.length; i++ ) {
+        if ( dtype_array_is_valid(a, i) != dtype_array_is_valid(b, i) ) { return false; }
+    }
+    return true;
+}
+
+/// @brief every proper prefix of the block must be rejected
+size_t test_truncated(const dtype block)
+{
+    size_t accepted = 0;
+    for ( size_t size = 0; size < block.size; size++ ) {
+        // a copy of exactly `size` bytes, so reading past it is caught by sanitizers
+        void * copy = malloc(size + 1);
+        memcpy(copy, block.mem, size);
+        dtype_array arr = dtype_array_decode(copy, size);
+        accepted += arr.mem != NULL || arr.length != 0;
+        dtype_array_clear(arr);
+        free(copy);
+    }
+    return accepted;
+}
+
+/// @brief round trip every codec suiting each type at every length, with & without nulls
+void test_round_trips()
+{
+    const enum DTYPE_TYPES types[] = {
+        DTYPE_BOOL, DTYPE_INT8, DTYPE_UINT16, DTYPE_INT32, DTYPE_INT64, DTYPE_UINT64, DTYPE_FLOAT, DTYPE_DOUBLE,
+    };
+    const enum DTYPE_CODECS codecs[] = { DTYPE_CODEC_RAW, DTYPE_CODEC_DELTA, DTYPE_CODEC_FOR, DTYPE_CODEC_XOR };
+    for ( size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++ ) {
+        bool integer = types[t] != DTYPE_BOOL && types[t] != DTYPE_FLOAT && types[t] != DTYPE_DOUBLE;
+        bool real = types[t] == DTYPE_FLOAT || types[t] == DTYPE_DOUBLE;
+        for ( size_t c = 0; c < 4; c++ ) {
+            bool suits = codecs[c] == DTYPE_CODEC_RAW || (codecs[c] == DTYPE_CODEC_XOR ? real : integer);
+            if ( !suits ) { continue; }
+            for ( size_t l = 0; l < sizeof(test_lengths) / sizeof(test_lengths[0]); l++ ) {
+                for ( int nulls = 0; nulls < 2; nulls++ ) {
+                    dtype_array arr = test_array(types[t], test_lengths[l], nulls);
+                    dtype block = dtype_array_encode(arr, codecs[c], dtype_default());
+                    dtype_array back = dtype_array_decode(block.mem, block.size);
+                    CHECK(block.type == DTYPE_CUSTOM && block.size >= 16);
+                    CHECK(test_same(arr, back));
+                    // the big lengths only add time here, truncation is the same past a few blocks
+                    CHECK(test_lengths[l] > 129 || test_truncated(block) == 0);
+                    dtype_array_clear(back);
+                    dtype_array_clear(arr);
+                    dtype_clear(block);
+                }
+            }
+        }
+    }
+}
+
+/// @brief blocks whose header doesn't match their content, or codecs not suiting the type
+void test_mismatched()
+{
+    dtype_array arr = test_array(DTYPE_INT32, 300, false);
+    CHECK(dtype_array_encode(arr, DTYPE_CODEC_XOR, dtype_default()).mem == NULL);
+    dtype block = dtype_array_encode(arr, DTYPE_CODEC_DELTA, dtype_default());
+    unsigned char * head = block.mem;
+    const unsigned char codecs[] = { DTYPE_CODEC_XOR, DTYPE_CODEC_DICT_RLE, DTYPE_CODEC_AUTO, 200 };
+    for ( size_t i = 0; i < sizeof(codecs); i++ ) {
+        head[0] = codecs[i];
+        CHECK(dtype_array_decode(block.mem, block.size).mem == NULL);
+    }
+    head[0] = DTYPE_CODEC_DELTA;
+    const unsigned char types[] = { DTYPE_BOOL, DTYPE_STRING, DTYPE_CUSTOM, DTYPE_NONE, 200 };
+    for ( size_t i = 0; i < sizeof(types); i++ ) {
+        head[1] = types[i];
+        CHECK(dtype_array_decode(block.mem, block.size).mem == NULL);
+    }
+    head[1] = DTYPE_INT32;
+    // more values than the blocks hold
+    uint64_t length = 100000;
+    memcpy(head + 8, &length, 8);
+    CHECK(dtype_array_decode(block.mem, block.size).mem == NULL);
+    dtype_clear(block);
+    dtype_array_clear(arr);
+
+    // delta header on bools, whose values are bit-packed
+    unsigned char bools[24] = { DTYPE_CODEC_DELTA, DTYPE_BOOL };
+    length = 1000;
+    memcpy(bools + 8, &length, 8);
+    CHECK(dtype_array_decode(bools, sizeof(bools)).mem == NULL);
+
+    // bits set past the length, in bool values & in the validity bitmap
+    dtype_array mask = dtype_array_new(DTYPE_BOOL, 3);
+    mask = dtype_array_set_valid(mask, 1, false);
+    block = dtype_array_encode(mask, DTYPE_CODEC_RAW, dtype_default());
+    head = block.mem;
+    CHECK(block.size == 32);
+    head[16] |= 0x80;
+    CHECK(dtype_array_decode(block.mem, block.size).mem == NULL);
+    head[16] &= 0x7f;
+    head[24] |= 0x10;
+    CHECK(dtype_array_decode(block.mem, block.size).mem == NULL);
+    head[24] &= 0x0f;
+    dtype_array back = dtype_array_decode(block.mem, block.size);
+    CHECK(back.mem != NULL && dtype_array_null_count(back) == 1);
+    dtype_array_clear(back);
+    dtype_array_clear(mask);
+    dtype_clear(block);
+}
+
+/// @brief round trip strings with nulls & runs, and reject truncated string blocks
+void test_strings()
+{
+    const char * words[] = { "debug", "info", "", "a longer value than the others" };
+    for ( size_t l = 0; l < sizeof(test_lengths) / sizeof(test_lengths[0]); l++ ) {
+        size_t length = test_lengths[l];
+        dtype * vals = calloc(length + 1, sizeof(dtype));
+        for ( size_t i = 0; i < length; i++ ) {
+            vals[i] = i % 5 == 4 ? dtype_default() : dtype_set_string(vals[i], (char *)words[(i / 3) % 4]);
+        }
+        dtype block = dtype_strings_encode(vals, length, dtype_default());
+        size_t count = 0;
+        dtype * back = dtype_strings_decode(block.mem, block.size, &count);
+        CHECK(back != NULL && count == length);
+        size_t mismatches = 0;
+        for ( size_t i = 0; back != NULL && i < count; i++ ) {
+            mismatches += back[i].type != vals[i].type
+                || (vals[i].type == DTYPE_STRING && strcmp(back[i].mem, vals[i].mem) != 0);
+        }
+        CHECK(mismatches == 0);
+        size_t accepted = 0;
+        for ( size_t size = 0; length <= 129 && size < block.size; size++ ) {
+            size_t n;
+            dtype * part = dtype_strings_decode(block.mem, size, &n);
+            accepted += part != NULL;
+            for ( size_t i = 0; part != NULL && i < n; i++ ) { dtype_clear(part[i]); }
+            free(part);
+        }
+        CHECK(accepted == 0);
+        for ( size_t i = 0; i < length; i++ ) {
+            dtype_clear(vals[i]);
+            back ? dtype_clear(back[i]) : dtype_default();
+        }
+        free(vals);
+        free(back);
+        dtype_clear(block);
+    }
+}
+
+int main()
+{
+    srand(7);
+    test_round_trips();
+    test_mismatched();
+    test_strings();
+    return test_done("test_codec");
+}
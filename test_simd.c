@@ -0,0 +1,321 @@
+#include <dtype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_check.h"
+
+// simd checks : every SIMD kernel must give the same bits as the scalar code it stands in for
+// build : gcc -O2 -I. test_simd.c dtype.c -o test_simd -lpthread && ./test_simd
+
+/// @brief number of random inputs per check
+#define TEST_COUNT (1 << 16)
+
+// internal functions under test, not part of dtype.h
+uint16_t dtype__float_to_half(float val);
+float dtype__half_to_float(uint16_t half);
+uint16_t dtype__float_to_bfloat(float val);
+float dtype__bfloat_to_float(uint16_t bfloat);
+size_t dtype__popcount64(uint64_t x);
+
+#if defined(TEST_X86_SIMD)
+bool dtype__cpu_has_f16c();
+bool dtype__cpu_has_avx2();
+size_t dtype__float_to_half_f16c(uint16_t * dst, const float * src, size_t count);
+size_t dtype__half_to_float_f16c(float * dst, const uint16_t * src, size_t count);
+size_t dtype__float_to_bfloat_avx2(uint16_t * dst, const float * src, size_t count);
+size_t dtype__bfloat_to_float_avx2(float * dst, const uint16_t * src, size_t count);
+bool dtype__cpu_has_popcnt();
+size_t dtype__bitmap_popcount_popcnt(const uint64_t * a, const uint64_t * b, size_t words);
+size_t dtype__bitmap_op_avx2(uint64_t * dst, const uint64_t * a, const uint64_t * b, size_t words, int op);
+size_t dtype__decode_delta_avx2(uint64_t * vals, size_t count, uint64_t * prev);
+size_t dtype__decode_for_avx2(uint64_t * vals, size_t count, uint64_t base);
+size_t dtype__decode_xor_avx2(uint64_t * vals, size_t count, unsigned shift, uint64_t * prev);
+size_t dtype__op_f64_avx2(double * acc, const double * rhs, size_t count, enum DTYPE_OPS op);
+size_t dtype__op_f32_avx2(float * acc, const float * rhs, size_t count, enum DTYPE_OPS op);
+size_t dtype__op_i64_avx2(uint64_t * acc, const uint64_t * rhs, size_t count, enum DTYPE_OPS op, bool sign);
+size_t dtype__cmp_f64_avx2(uint64_t * bits, const double * a, const double * b, size_t count, enum DTYPE_CMPS op);
+size_t dtype__cmp_f32_avx2(uint64_t * bits, const float * a, const float * b, size_t count, enum DTYPE_CMPS op);
+size_t dtype__cmp_i64_avx2(uint64_t * bits, const uint64_t * a, const uint64_t * b, size_t count, enum DTYPE_CMPS op, bool sign);
+#endif
+
+/// @brief random 64-bit value
+uint64_t test_rand64()
+{
+    uint64_t x = 0;
+    for ( int i = 0; i < 4; i++ ) { x = (x << 16) ^ (uint64_t)(rand() & 0xffff); }
+    return x;
+}
+
+/// @brief random float bits, with the special & boundary values of half precision mixed in
+void test_floats(float * vals, size_t count)
+{
+    const uint32_t special[] = {
+        0x00000000, 0x80000000, 0x7f800000, 0xff800000, 0x7fc00000, 0x7f800001, 0xffbfffff,
+        0x477ff000, 0x477fefff, 0x38800000, 0x387fffff, 0x33000000, 0x33000001, 0x32ffffff,
+        0x3f801000, 0x3f803000, 0x3f808000, 0x3f818000, 0x00000001, 0x007fffff,
+    };
+    size_t nspecial = sizeof(special) / sizeof(special[0]);
+    for ( size_t i = 0; i < count; i++ ) {
+        uint32_t x = i < nspecial ? special[i] : (uint32_t)test_rand64();
+        memcpy(vals + i, &x, sizeof(x));
+    }
+}
+
+/// @brief the half & brain float kernels against the scalar conversions
+void test_half_bfloat()
+{
+#if defined(TEST_X86_SIMD)
+    float * src = malloc(TEST_COUNT * sizeof(float));
+    float * back = malloc(65536 * sizeof(float));
+    uint16_t * bits = malloc(65536 * sizeof(uint16_t));
+    uint16_t * out = malloc(TEST_COUNT * sizeof(uint16_t));
+    test_floats(src, TEST_COUNT);
+    for ( size_t i = 0; i < 65536; i++ ) { bits[i] = (uint16_t)i; }
+    size_t mismatches = 0;
+    if ( dtype__cpu_has_f16c() ) {
+        size_t done = dtype__float_to_half_f16c(out, src, TEST_COUNT);
+        CHECK(done == TEST_COUNT);
+        for ( size_t i = 0; i < done; i++ ) { mismatches += out[i] != dtype__float_to_half(src[i]); }
+        CHECK(mismatches == 0);
+        // every half value
+        done = dtype__half_to_float_f16c(back, bits, 65536);
+        CHECK(done == 65536);
+        mismatches = 0;
+        for ( size_t i = 0; i < done; i++ ) {
+            float ref = dtype__half_to_float(bits[i]);
+            mismatches += memcmp(back + i, &ref, sizeof(float)) != 0;
+        }
+        CHECK(mismatches == 0);
+    }
+    if ( dtype__cpu_has_avx2() ) {
+        size_t done = dtype__float_to_bfloat_avx2(out, src, TEST_COUNT);
+        CHECK(done == TEST_COUNT);
+        mismatches = 0;
+        for ( size_t i = 0; i < done; i++ ) { mismatches += out[i] != dtype__float_to_bfloat(src[i]); }
+        CHECK(mismatches == 0);
+        done = dtype__bfloat_to_float_avx2(back, bits, 65536);
+        CHECK(done == 65536);
+        mismatches = 0;
+        for ( size_t i = 0; i < done; i++ ) {
+            float ref = dtype__bfloat_to_float(bits[i]);
+            mismatches += memcmp(back + i, &ref, sizeof(float)) != 0;
+        }
+        CHECK(mismatches == 0);
+    }
+    // a partial vector is left to the scalar tail
+    CHECK(!dtype__cpu_has_f16c() || dtype__float_to_half_f16c(out, src, 7) == 0);
+    free(src);
+    free(back);
+    free(bits);
+    free(out);
+#endif
+}
+
+/// @brief the bitmap kernels against word by word and / or / not & popcount, over lengths around the vector size
+void test_bitmaps()
+{
+#if defined(TEST_X86_SIMD)
+    uint64_t a[67], b[67], dst[67];
+    for ( size_t words = 0; words <= 67; words++ ) {
+        for ( size_t i = 0; i < words; i++ ) {
+            a[i] = test_rand64();
+            b[i] = i % 5 ? test_rand64() : ~(uint64_t)0;
+        }
+        if ( dtype__cpu_has_popcnt() ) {
+            size_t ref = 0, ref_and = 0;
+            for ( size_t i = 0; i < words; i++ ) {
+                ref += dtype__popcount64(a[i]);
+                ref_and += dtype__popcount64(a[i] & b[i]);
+            }
+            CHECK(dtype__bitmap_popcount_popcnt(a, NULL, words) == ref);
+            CHECK(dtype__bitmap_popcount_popcnt(a, b, words) == ref_and);
+        }
+        for ( int op = 0; dtype__cpu_has_avx2() && op < 3; op++ ) {
+            size_t done = dtype__bitmap_op_avx2(dst, a, b, words, op);
+            CHECK(done == words / 4 * 4);
+            size_t mismatches = 0;
+            for ( size_t i = 0; i < done; i++ ) {
+                uint64_t ref = op == 2 ? ~a[i] : (op ? a[i] | b[i] : a[i] & b[i]);
+                mismatches += dst[i] != ref;
+            }
+            CHECK(mismatches == 0);
+        }
+    }
+#endif
+}
+
+/// @brief the delta, for & xor decode kernels against the scalar prefix sum & prefix xor
+void test_decode_kernels()
+{
+#if defined(TEST_X86_SIMD)
+    if ( !dtype__cpu_has_avx2() ) { return; }
+    uint64_t vals[131], ref[131];
+    for ( size_t count = 0; count <= 131; count += count < 8 ? 1 : 41 ) {
+        uint64_t start = test_rand64(), base = test_rand64();
+        for ( size_t i = 0; i < count; i++ ) {
+            // large values too, so sums wrap & zigzag signs are mixed
+            vals[i] = i % 3 ? test_rand64() : test_rand64() >> 50;
+        }
+        uint64_t prev = start, ref_prev = start;
+        memcpy(ref, vals, count * sizeof(uint64_t));
+        size_t done = dtype__decode_delta_avx2(vals, count, &prev);
+        CHECK(done == count / 4 * 4);
+        size_t mismatches = 0;
+        for ( size_t i = 0; i < done; i++ ) {
+            ref_prev += (ref[i] >> 1) ^ (~(ref[i] & 1) + 1);
+            mismatches += vals[i] != ref_prev;
+        }
+        CHECK(mismatches == 0 && prev == ref_prev);
+
+        memcpy(vals, ref, count * sizeof(uint64_t));
+        done = dtype__decode_for_avx2(vals, count, base);
+        mismatches = 0;
+        for ( size_t i = 0; i < done; i++ ) { mismatches += vals[i] != ref[i] + base; }
+        CHECK(done == count / 4 * 4 && mismatches == 0);
+
+        for ( unsigned shift = 0; shift < 64; shift += 21 ) {
+            memcpy(vals, ref, count * sizeof(uint64_t));
+            prev = ref_prev = start;
+            done = dtype__decode_xor_avx2(vals, count, shift, &prev);
+            mismatches = 0;
+            for ( size_t i = 0; i < done; i++ ) {
+                ref_prev ^= ref[i] << shift;
+                mismatches += vals[i] != ref_prev;
+            }
+            CHECK(done == count / 4 * 4 && mismatches == 0 && prev == ref_prev);
+        }
+    }
+#endif
+}
+
+/// @brief number of elements in the arithmetic checks, not a multiple of the vector width
+#define TEST_ARITH 203
+
+/// @brief scalar reference of `a op b` for doubles
+double test_op_f64(double a, double b, enum DTYPE_OPS op)
+{
+    switch ( op )
+    {
+        case DTYPE_OP_ADD: return a + b;
+        case DTYPE_OP_SUB: return a - b;
+        case DTYPE_OP_MUL: return a * b;
+        case DTYPE_OP_DIV: return a / b;
+        case DTYPE_OP_MIN: return a < b ? a : b;
+        default: return a > b ? a : b;
+    }
+}
+
+/// @brief scalar reference of `a op b` for 64-bit integers [ mul & div are never vectorized ]
+uint64_t test_op_i64(uint64_t a, uint64_t b, enum DTYPE_OPS op, bool sign)
+{
+    bool less = sign ? (int64_t)a < (int64_t)b : a < b;
+    switch ( op )
+    {
+        case DTYPE_OP_ADD: return a + b;
+        case DTYPE_OP_SUB: return a - b;
+        case DTYPE_OP_MIN: return less ? a : b;
+        default: return less ? b : a;
+    }
+}
+
+/// @brief scalar reference of `a cmp b` from the order of a & b [ unordered for nan ]
+bool test_cmp(int order, bool unordered, enum DTYPE_CMPS op)
+{
+    switch ( op )
+    {
+        case DTYPE_CMP_EQ: return !unordered && order == 0;
+        case DTYPE_CMP_NE: return unordered || order != 0;
+        case DTYPE_CMP_LT: return !unordered && order < 0;
+        case DTYPE_CMP_LE: return !unordered && order <= 0;
+        case DTYPE_CMP_GT: return !unordered && order > 0;
+        default: return !unordered && order >= 0;
+    }
+}
+
+/// @brief the arithmetic & comparison kernels against scalar references, with nan, infinities & signed zeros
+void test_arith_kernels()
+{
+#if defined(TEST_X86_SIMD)
+    if ( !dtype__cpu_has_avx2() ) { return; }
+    const double special[] = { 0.0, -0.0, 1.0 / 0.0, -1.0 / 0.0, 0.0 / 0.0, 1e308, -1e-310, 3.0 };
+    const uint64_t extreme[] = { 0, 1, ~(uint64_t)0, (uint64_t)1 << 63, ((uint64_t)1 << 63) - 1, 42 };
+    double da[TEST_ARITH], db[TEST_ARITH], dacc[TEST_ARITH];
+    float fa[TEST_ARITH], fb[TEST_ARITH], facc[TEST_ARITH];
+    uint64_t ia[TEST_ARITH], ib[TEST_ARITH], iacc[TEST_ARITH];
+    for ( size_t i = 0; i < TEST_ARITH; i++ ) {
+        da[i] = i % 4 ? (double)(rand() % 21 - 10) / 4 : special[(i / 4) % 8];
+        db[i] = i % 3 ? (double)(rand() % 21 - 10) / 4 : special[(i / 3) % 8];
+        // equal operands too, so eq, le & ge are exercised
+        db[i] = i % 5 == 0 ? da[i] : db[i];
+        fa[i] = (float)da[i];
+        fb[i] = (float)db[i];
+        ia[i] = i % 4 ? test_rand64() % 64 - 32 : extreme[(i / 4) % 6];
+        ib[i] = i % 5 == 0 ? ia[i] : ( i % 3 ? test_rand64() % 64 - 32 : extreme[(i / 3) % 6] );
+    }
+    for ( int op = DTYPE_OP_ADD; op <= DTYPE_OP_MAX; op++ ) {
+        size_t mismatches = 0;
+        memcpy(dacc, da, sizeof(da));
+        size_t done = dtype__op_f64_avx2(dacc, db, TEST_ARITH, op);
+        for ( size_t i = 0; i < done; i++ ) {
+            double ref = test_op_f64(da[i], db[i], op);
+            mismatches += memcmp(&ref, dacc + i, sizeof(double)) != 0;
+        }
+        CHECK(done == TEST_ARITH / 4 * 4 && mismatches == 0);
+        memcpy(facc, fa, sizeof(fa));
+        done = dtype__op_f32_avx2(facc, fb, TEST_ARITH, op);
+        for ( size_t i = 0; i < done; i++ ) {
+            float ref = (float)test_op_f64(fa[i], fb[i], op);
+            mismatches += memcmp(&ref, facc + i, sizeof(float)) != 0;
+        }
+        CHECK(done == TEST_ARITH / 8 * 8 && mismatches == 0);
+        for ( int sign = 0; sign < 2; sign++ ) {
+            memcpy(iacc, ia, sizeof(ia));
+            done = dtype__op_i64_avx2(iacc, ib, TEST_ARITH, op, sign);
+            for ( size_t i = 0; i < done; i++ ) { mismatches += iacc[i] != test_op_i64(ia[i], ib[i], op, sign); }
+            bool vector = op != DTYPE_OP_MUL && op != DTYPE_OP_DIV;
+            CHECK(done == (vector ? TEST_ARITH / 4 * 4 : 0) && mismatches == 0);
+        }
+    }
+    for ( int op = DTYPE_CMP_EQ; op <= DTYPE_CMP_GE; op++ ) {
+        uint64_t bits[4], ref[4];
+        size_t done[4];
+        memset(bits, 0, sizeof(bits));
+        memset(ref, 0, sizeof(ref));
+        done[0] = dtype__cmp_f64_avx2(bits, da, db, TEST_ARITH, op);
+        for ( size_t i = 0; i < done[0]; i++ ) {
+            bool res = test_cmp(da[i] < db[i] ? -1 : da[i] > db[i], da[i] != da[i] || db[i] != db[i], op);
+            ref[i / 64] |= (uint64_t)res << (i % 64);
+        }
+        CHECK(done[0] == TEST_ARITH / 4 * 4 && memcmp(bits, ref, sizeof(bits)) == 0);
+        memset(bits, 0, sizeof(bits));
+        memset(ref, 0, sizeof(ref));
+        done[1] = dtype__cmp_f32_avx2(bits, fa, fb, TEST_ARITH, op);
+        for ( size_t i = 0; i < done[1]; i++ ) {
+            bool res = test_cmp(fa[i] < fb[i] ? -1 : fa[i] > fb[i], fa[i] != fa[i] || fb[i] != fb[i], op);
+            ref[i / 64] |= (uint64_t)res << (i % 64);
+        }
+        CHECK(done[1] == TEST_ARITH / 8 * 8 && memcmp(bits, ref, sizeof(bits)) == 0);
+        for ( int sign = 0; sign < 2; sign++ ) {
+            memset(bits, 0, sizeof(bits));
+            memset(ref, 0, sizeof(ref));
+            done[2 + sign] = dtype__cmp_i64_avx2(bits, ia, ib, TEST_ARITH, op, sign);
+            for ( size_t i = 0; i < done[2 + sign]; i++ ) {
+                bool less = sign ? (int64_t)ia[i] < (int64_t)ib[i] : ia[i] < ib[i];
+                bool res = test_cmp(less ? -1 : ia[i] != ib[i], false, op);
+                ref[i / 64] |= (uint64_t)res << (i % 64);
+            }
+            CHECK(done[2 + sign] == TEST_ARITH / 4 * 4 && memcmp(bits, ref, sizeof(bits)) == 0);
+        }
+    }
+#endif
+}
+
+int main()
+{
+    srand(7);
+    test_half_bfloat();
+    test_bitmaps();
+    test_decode_kernels();
+    test_arith_kernels();
+    return test_done("test_simd");
+}
@@ -0,0 +1,252 @@
+#include <dtype.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "test_check.h"
+
+// store checks : reopening gives the last checkpoint, also after torn, failed & stale log frames
+// a corrupt frame that passes its checksum fails the open instead
+// build : gcc -O2 -I. test_store.c dtype.c -o test_store -lpthread && ./test_store
+
+// internal checksum of log frames
+uint64_t dtype__hash_str(const char * str, size_t len);
+
+/// @brief file prefix of the checked store
+#define TEST_STORE "/tmp/dtype_test_store"
+/// @brief number of slots
+#define TEST_SLOTS 500
+
+/// @brief a custom slot value
+typedef struct {
+    int x;
+    int y;
+} test_custom;
+
+/// @brief value of slot in given generation : ints, strings, custom values & empty slots
+dtype test_value(size_t slot, int gen, dtype var)
+{
+    char text[64];
+    test_custom custom = { (int)slot, gen };
+    switch ( slot % 4 )
+    {
+        case 0: return dtype_set_int(var, (int)slot * 1000 + gen);
+        case 1:
+            snprintf(text, sizeof(text), "slot %zu gen %d", slot, gen);
+            return dtype_set_string(var, text);
+        case 2: return dtype_set_custom(var, &custom, sizeof(custom));
+        default: return dtype_clear(var);
+    }
+}
+
+/// @brief set every `step`-th slot to its value in given generation
+void test_fill(dtype_store * store, int gen, size_t step)
+{
+    dtype val = dtype_default();
+    for ( size_t slot = 0; slot < TEST_SLOTS; slot += step ) {
+        val = test_value(slot, gen, val);
+        dtype_store_set(store, slot, val);
+    }
+    dtype_clear(val);
+}
+
+/// @brief count slots of store not holding their value of `gens[slot % 2]`
+size_t test_mismatches(dtype_store * store, const int gens[2])
+{
+    size_t mismatches = 0;
+    dtype val = dtype_default(), ref = dtype_default();
+    for ( size_t slot = 0; slot < TEST_SLOTS; slot++ ) {
+        val = dtype_store_get(store, slot, val);
+        ref = test_value(slot, gens[slot % 2], ref);
+        mismatches += val.type != ref.type || val.size != ref.size || (val.size && memcmp(val.mem, ref.mem, val.size) != 0);
+    }
+    dtype_clear(val);
+    dtype_clear(ref);
+    return mismatches;
+}
+
+/// @brief remove the files of the store
+void test_remove()
+{
+    remove(TEST_STORE ".base");
+    remove(TEST_STORE ".base.tmp");
+    remove(TEST_STORE ".log");
+}
+
+/// @brief append bytes to a store file, as a crash or another writer would have left them
+void test_append(const char * path, const void * mem, size_t size)
+{
+    FILE * f = fopen(path, "ab");
+    if ( f != NULL ) {
+        fwrite(mem, 1, size, f);
+        fclose(f);
+    }
+}
+
+/// @brief size of a store file
+long test_size(const char * path)
+{
+    FILE * f = fopen(path, "rb");
+    if ( f == NULL ) { return -1; }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+/// @brief full & delta checkpoints are both recovered, unsaved changes are not
+void test_reopen()
+{
+    test_remove();
+    dtype_store * store = dtype_store_open(TEST_STORE, TEST_SLOTS);
+    CHECK(store != NULL && dtype_store_slots(store) == TEST_SLOTS);
+    test_fill(store, 1, 1);
+    CHECK(dtype_store_checkpoint(store));
+    // odd slots change, so the second checkpoint is a delta in the log
+    test_fill(store, 2, 2);
+    for ( size_t slot = 1; slot < TEST_SLOTS; slot += 2 ) {
+        dtype val = test_value(slot, 2, dtype_default());
+        dtype_store_set(store, slot, val);
+        dtype_clear(val);
+    }
+    CHECK(dtype_store_checkpoint(store));
+    CHECK(test_size(TEST_STORE ".log") > 0);
+    test_fill(store, 3, 1);
+    dtype_store_close(store);
+    store = dtype_store_open(TEST_STORE, 1);
+    const int gens[2] = { 2, 2 };
+    CHECK(store != NULL && dtype_store_slots(store) == TEST_SLOTS && test_mismatches(store, gens) == 0);
+    // a none value holding memory has no type to store
+    dtype raw = dtype_change_size(dtype_default(), 8);
+    CHECK(!dtype_store_set(store, 0, raw));
+    dtype_clear(raw);
+    dtype_store_close(store);
+}
+
+/// @brief a frame torn by a crash is dropped & cut off the log on reopen
+void test_torn_frame()
+{
+    const unsigned char torn[] = { 'D', 'T', 'L', 'G', 0, 0, 0, 0, 9, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3 };
+    long size = test_size(TEST_STORE ".log");
+    test_append(TEST_STORE ".log", torn, sizeof(torn));
+    dtype_store * store = dtype_store_open(TEST_STORE, TEST_SLOTS);
+    const int gens[2] = { 2, 2 };
+    CHECK(store != NULL && test_mismatches(store, gens) == 0);
+    CHECK(test_size(TEST_STORE ".log") == size);
+    // later checkpoints follow the last good frame
+    test_fill(store, 4, 2);
+    CHECK(dtype_store_checkpoint(store));
+    dtype_store_close(store);
+    store = dtype_store_open(TEST_STORE, TEST_SLOTS);
+    const int after[2] = { 4, 2 };
+    CHECK(store != NULL && test_mismatches(store, after) == 0);
+    dtype_store_close(store);
+}
+
+/// @brief a checkpoint failing half way doesn't hide the checkpoints after it
+void test_failed_frame()
+{
+    dtype_store * store = dtype_store_open(TEST_STORE, TEST_SLOTS);
+    CHECK(store != NULL);
+    if ( store == NULL ) { return; }
+    // a file size limit makes the write of a large frame fail part way
+    struct rlimit saved, limit;
+    getrlimit(RLIMIT_FSIZE, &saved);
+    limit = saved;
+    limit.rlim_cur = (rlim_t)test_size(TEST_STORE ".log") + 4096;
+    void (* handler)(int) = signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &limit);
+    char * big = calloc(1, 16384);
+    memset(big, 'x', 16383);
+    dtype val = dtype_set_string(dtype_default(), big);
+    dtype_store_set(store, 1, val);
+    CHECK(!dtype_store_checkpoint(store));
+    setrlimit(RLIMIT_FSIZE, &saved);
+    signal(SIGXFSZ, handler);
+    test_fill(store, 5, 1);
+    CHECK(dtype_store_checkpoint(store));
+    dtype_store_close(store);
+    store = dtype_store_open(TEST_STORE, TEST_SLOTS);
+    const int gens[2] = { 5, 5 };
+    CHECK(store != NULL && test_mismatches(store, gens) == 0);
+    dtype_store_close(store);
+    dtype_clear(val);
+    free(big);
+}
+
+/// @brief frames left in the log by a crash between a compaction & emptying the log are skipped
+void test_stale_frames()
+{
+    dtype_store * store = dtype_store_open(TEST_STORE, TEST_SLOTS);
+    CHECK(store != NULL && dtype_store_compact(store));
+    // a few changes after a compaction are a delta frame
+    test_fill(store, 6, 50);
+    CHECK(dtype_store_checkpoint(store));
+    long size = test_size(TEST_STORE ".log");
+    FILE * f = fopen(TEST_STORE ".log", "rb");
+    unsigned char * log = malloc(size > 0 ? (size_t)size : 1);
+    size_t got = f != NULL ? fread(log, 1, (size_t)size, f) : 0;
+    f != NULL ? fclose(f) : 0;
+    CHECK(size > 0 && got == (size_t)size);
+    test_fill(store, 7, 1);
+    CHECK(dtype_store_compact(store));
+    CHECK(test_size(TEST_STORE ".log") == 0);
+    dtype_store_close(store);
+    test_append(TEST_STORE ".log", log, got);
+    store = dtype_store_open(TEST_STORE, TEST_SLOTS);
+    const int gens[2] = { 7, 7 };
+    CHECK(store != NULL && test_mismatches(store, gens) == 0);
+    CHECK(test_size(TEST_STORE ".log") == 0);
+    dtype_store_close(store);
+    free(log);
+}
+
+/// @brief append a checksummed frame newer than any checkpoint, holding given payload
+void test_append_frame(const unsigned char * payload, uint64_t size)
+{
+    unsigned char head[40] = { 'D', 'T', 'L', 'G' };
+    const uint64_t seq = (uint64_t)1 << 40, entries = 1, sum = dtype__hash_str((const char *)payload, size);
+    memcpy(head + 8, &seq, 8);
+    memcpy(head + 16, &entries, 8);
+    memcpy(head + 24, &size, 8);
+    memcpy(head + 32, &sum, 8);
+    test_append(TEST_STORE ".log", head, sizeof(head));
+    test_append(TEST_STORE ".log", payload, size);
+}
+
+/// @brief a complete frame that can't be applied fails the open & stays in the log
+void test_corrupt_frame()
+{
+    long size = test_size(TEST_STORE ".log");
+    // slot 0 set to a record of unknown type
+    const unsigned char unknown[] = { 0, 0xEE, 0 };
+    test_append_frame(unknown, sizeof(unknown));
+    long corrupt = test_size(TEST_STORE ".log");
+    CHECK(dtype_store_open(TEST_STORE, TEST_SLOTS) == NULL);
+    CHECK(test_size(TEST_STORE ".log") == corrupt);
+    CHECK(truncate(TEST_STORE ".log", size) == 0);
+    // slot UINT64_MAX set to a none value
+    const unsigned char huge[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, DTYPE_NONE, 0 };
+    test_append_frame(huge, sizeof(huge));
+    corrupt = test_size(TEST_STORE ".log");
+    CHECK(dtype_store_open(TEST_STORE, TEST_SLOTS) == NULL);
+    CHECK(test_size(TEST_STORE ".log") == corrupt);
+    CHECK(truncate(TEST_STORE ".log", size) == 0);
+    dtype_store * store = dtype_store_open(TEST_STORE, TEST_SLOTS);
+    const int gens[2] = { 7, 7 };
+    CHECK(store != NULL && test_mismatches(store, gens) == 0);
+    store != NULL ? dtype_store_close(store) : (void)0;
+}
+
+int main()
+{
+    test_reopen();
+    test_torn_frame();
+    test_failed_frame();
+    test_stale_frames();
+    test_corrupt_frame();
+    test_remove();
+    return test_done("test_store");
+}
@@ -0,0 +1,197 @@
+#include <dtype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_check.h"
+
+// writer checks : every record counted in the stats is in the file, in order per producer
+// build : gcc -O2 -I. test_writer.c dtype.c -o test_writer -lpthread && ./test_writer
+
+/// @brief file written by the checks
+#define TEST_FILE "/tmp/dtype_test_writer"
+/// @brief number of producer threads
+#define TEST_THREADS 4
+/// @brief records put by each producer
+#define TEST_RECORDS 50000
+
+/// @brief a record payload : producer & sequence within it
+typedef struct {
+    uint32_t producer;
+    uint32_t seq;
+} test_record;
+
+/// @brief arguments of a producer thread
+typedef struct {
+    dtype_writer * writer;
+    uint32_t id;
+    size_t put;
+} test_producer;
+
+/// @brief put records from one thread, every 10th as a string to mix record sizes
+void * test_produce(void * arg)
+{
+    test_producer * t = arg;
+    dtype_producer * p = dtype_writer_producer(t->writer);
+    dtype val = dtype_default();
+    char text[64];
+    for ( uint32_t seq = 0; p != NULL && seq < TEST_RECORDS; seq++ ) {
+        test_record rec = { t->id, seq };
+        if ( seq % 10 ) {
+            val = dtype_set_custom(val, &rec, sizeof(rec));
+        } else {
+            snprintf(text, sizeof(text), "%u:%u", t->id, seq);
+            val = dtype_set_string(val, text);
+        }
+        t->put += dtype_writer_put(p, val);
+    }
+    dtype_clear(val);
+    return NULL;
+}
+
+/// @brief read the whole file
+/// @return malloc'd content, NULL if the file can't be read
+unsigned char * test_read(const char * path, size_t * size)
+{
+    FILE * f = fopen(path, "rb");
+    if ( f == NULL ) { return NULL; }
+    fseek(f, 0, SEEK_END);
+    *size = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char * mem = malloc(*size + 1);
+    if ( fread(mem, 1, *size, f) != *size ) {
+        free(mem);
+        mem = NULL;
+    }
+    fclose(f);
+    return mem;
+}
+
+/// @brief run the producers with given policy & check the file against the stats
+void test_policy(enum DTYPE_BACKPRESSURE policy, size_t buffer_size)
+{
+    remove(TEST_FILE);
+    dtype_writer * writer = dtype_writer_open(TEST_FILE, buffer_size, policy);
+    CHECK(writer != NULL);
+    if ( writer == NULL ) { return; }
+    pthread_t threads[TEST_THREADS];
+    test_producer args[TEST_THREADS];
+    for ( uint32_t i = 0; i < TEST_THREADS; i++ ) {
+        args[i].writer = writer;
+        args[i].id = i;
+        args[i].put = 0;
+        pthread_create(&threads[i], NULL, test_produce, &args[i]);
+    }
+    size_t put = 0;
+    for ( int i = 0; i < TEST_THREADS; i++ ) {
+        pthread_join(threads[i], NULL);
+        put += args[i].put;
+    }
+    CHECK(dtype_writer_flush(writer));
+    dtype_writer_stats stats = dtype_writer_get_stats(writer);
+    CHECK(dtype_writer_close(writer));
+    CHECK(stats.records == put && stats.records + stats.dropped == TEST_THREADS * TEST_RECORDS);
+    CHECK(policy == DTYPE_BACKPRESSURE_DROP || stats.dropped == 0);
+    CHECK(policy == DTYPE_BACKPRESSURE_GROW || stats.grows == 0);
+    CHECK(stats.bytes_discarded == 0 && stats.queue_depth == 0);
+
+    size_t size = 0, at = 0, records = 0, disorder = 0;
+    unsigned char * mem = test_read(TEST_FILE, &size);
+    CHECK(mem != NULL && size == stats.bytes_written);
+    // each producer's records are in order, dropped ones leave gaps
+    long next[TEST_THREADS] = { 0 };
+    dtype val = dtype_default();
+    while ( mem != NULL && at < size ) {
+        size_t used;
+        val = dtype_record_decode(mem + at, size - at, &used, val);
+        if ( !used ) { break; }
+        test_record rec = { 0, 0 };
+        if ( val.type == DTYPE_CUSTOM && val.size == sizeof(rec) ) {
+            memcpy(&rec, val.mem, sizeof(rec));
+        } else if ( val.type != DTYPE_STRING || sscanf(val.mem, "%u:%u", &rec.producer, &rec.seq) != 2 ) {
+            break;
+        }
+        disorder += rec.producer >= TEST_THREADS || (long)rec.seq < next[rec.producer];
+        next[rec.producer % TEST_THREADS] = (long)rec.seq + 1;
+        records++;
+        at += used;
+    }
+    CHECK(at == size && records == stats.records && disorder == 0);
+    dtype_clear(val);
+    free(mem);
+    remove(TEST_FILE);
+}
+
+/// @brief number of short lived threads, more than the writer has producer slots
+#define TEST_CHURN 300
+
+/// @brief put one record from a short lived thread & release its producer
+void * test_churn(void * arg)
+{
+    test_producer * t = arg;
+    dtype_producer * p = dtype_writer_producer(t->writer);
+    if ( p == NULL ) { return NULL; }
+    dtype val = dtype_set_int(dtype_default(), (int)t->id);
+    t->put += dtype_writer_put(p, val);
+    dtype_writer_release_producer(p);
+    dtype_clear(val);
+    return NULL;
+}
+
+/// @brief released producers are reused, so thread churn doesn't run out of them
+void test_release()
+{
+    remove(TEST_FILE);
+    dtype_writer * writer = dtype_writer_open(TEST_FILE, 1024, DTYPE_BACKPRESSURE_BLOCK);
+    CHECK(writer != NULL);
+    if ( writer == NULL ) { return; }
+    test_producer arg = { writer, 0, 0 };
+    for ( ; arg.id < TEST_CHURN; arg.id++ ) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, test_churn, &arg);
+        pthread_join(thread, NULL);
+    }
+    CHECK(arg.put == TEST_CHURN);
+    CHECK(dtype_writer_close(writer));
+
+    size_t size = 0, at = 0, records = 0;
+    unsigned char * mem = test_read(TEST_FILE, &size);
+    dtype val = dtype_default();
+    while ( mem != NULL && at < size ) {
+        size_t used;
+        val = dtype_record_decode(mem + at, size - at, &used, val);
+        if ( !used || val.type != DTYPE_INT || dtype_get_int(val) != (int)records ) { break; }
+        records++;
+        at += used;
+    }
+    CHECK(at == size && records == TEST_CHURN);
+    dtype_clear(val);
+    free(mem);
+    remove(TEST_FILE);
+}
+
+/// @brief flush & close report a file that can't be written
+void test_failure()
+{
+    dtype_writer * writer = dtype_writer_open("/dev/full", 1024, DTYPE_BACKPRESSURE_BLOCK);
+    if ( writer == NULL ) { return; }
+    dtype_producer * p = dtype_writer_producer(writer);
+    dtype val = dtype_set_int(dtype_default(), 7);
+    CHECK(dtype_writer_put(p, val));
+    CHECK(!dtype_writer_flush(writer));
+    // nothing reached the file, so nothing counts as written
+    dtype_writer_stats stats = dtype_writer_get_stats(writer);
+    CHECK(stats.bytes_written == 0 && stats.bytes_discarded > 0 && stats.queue_depth == 0);
+    CHECK(!dtype_writer_close(writer));
+    dtype_clear(val);
+}
+
+int main()
+{
+    test_policy(DTYPE_BACKPRESSURE_BLOCK, 4096);
+    test_policy(DTYPE_BACKPRESSURE_GROW, 4096);
+    test_policy(DTYPE_BACKPRESSURE_DROP, 4096);
+    test_release();
+    test_failure();
+    return test_done("test_writer");
+}